@@ -0,0 +1,116 @@
+#include "affinity.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fstream>
+#include <sched.h>
+#include <string>
+#endif
+
+#ifndef _WIN32
+namespace {
+
+// parse "0-3,8,10-11"
+std::vector<size_t> parseCpuList(const std::string &list) {
+    std::vector<size_t> ret;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        auto end = list.find(',', pos);
+        auto item = list.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        if (auto dash = item.find('-'); dash != std::string::npos) {
+            for (size_t i = std::stoull(item.substr(0, dash)); i <= std::stoull(item.substr(dash + 1)); ++i) {
+                ret.push_back(i);
+            }
+        } else if (!item.empty()) {
+            ret.push_back(std::stoull(item));
+        }
+        if (end == std::string::npos) {
+            break;
+        }
+        pos = end + 1;
+    }
+    return ret;
+}
+
+} // namespace
+#endif // _WIN32
+
+std::vector<std::vector<size_t>> numaCores() {
+    std::vector<std::vector<size_t>> ret;
+#ifdef _WIN32
+    DWORD_PTR process, system;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &process, &system)) {
+        return ret;
+    }
+    ULONG highest = 0;
+    if (!GetNumaHighestNodeNumber(&highest)) {
+        highest = 0;
+    }
+    for (ULONG node = 0; node <= highest; ++node) {
+        ULONGLONG mask = 0;
+        if (highest != 0 && !GetNumaNodeProcessorMask(UCHAR(node), &mask)) {
+            continue;
+        }
+        // single node: every core of process
+        mask = highest == 0 ? ULONGLONG(process) : mask & ULONGLONG(process);
+        std::vector<size_t> cores;
+        for (size_t i = 0; i < sizeof(mask) * 8; ++i) {
+            if (mask & (ULONGLONG(1) << i)) {
+                cores.push_back(i);
+            }
+        }
+        if (!cores.empty()) {
+            ret.push_back(std::move(cores));
+        }
+    }
+#else  // _WIN32
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return ret;
+    }
+    for (size_t node = 0;; ++node) {
+        std::ifstream f("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!f) {
+            break;
+        }
+        std::string list;
+        std::getline(f, list);
+        auto cores = parseCpuList(list);
+        std::erase_if(cores, [&](size_t c) { return c >= CPU_SETSIZE || !CPU_ISSET(c, &allowed); });
+        if (!cores.empty()) {
+            ret.push_back(std::move(cores));
+        }
+    }
+    if (ret.empty()) {
+        std::vector<size_t> cores;
+        for (size_t c = 0; c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &allowed)) {
+                cores.push_back(c);
+            }
+        }
+        if (!cores.empty()) {
+            ret.push_back(std::move(cores));
+        }
+    }
+#endif // _WIN32
+    return ret;
+}
+
+bool pinThisThread(size_t core) {
+#ifdef _WIN32
+    if (core >= sizeof(DWORD_PTR) * 8) {
+        return false;
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core) != 0;
+#else  // _WIN32
+    if (core >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#endif // _WIN32
+}
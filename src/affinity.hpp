@@ -0,0 +1,28 @@
+/**
+ * @file affinity.hpp
+ * @author glutamate
+ * @brief pin threads to logical cores
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief logical cores this process may run on, grouped by NUMA node in node order
+ *
+ * @return one group if NUMA topology is unknown, empty if cores are unknown
+ */
+std::vector<std::vector<size_t>> numaCores();
+
+/**
+ * @brief restrict calling thread to one logical core
+ *
+ * @return if succeeded
+ */
+bool pinThisThread(size_t core);
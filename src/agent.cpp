@@ -48,15 +48,19 @@ class AgentModel : public CSModelObject {
         while (!l.link(host, port)) {
             std::this_thread::sleep_for(std::chrono::seconds(1));
         }
-        auto s = tools::myany::printAnyToString<tools::myany::PythonFormat>(value);
-        l.sendValue("[" + s + "]");
+        sendBuffer = "[";
+        tools::myany::appendCSValueMapToString<tools::myany::PythonFormat>(sendBuffer, value);
+        sendBuffer += "]";
+        l.sendValue(sendBuffer);
         return true;
     };
 
     virtual bool Tick(double time) override {
-        auto s = tools::myany::printAnyToString<tools::myany::PythonFormat>(std::move(inputBuffer));
+        // reuse capacity of last frame
+        sendBuffer.clear();
+        tools::myany::appendListToString<tools::myany::PythonFormat>(sendBuffer, inputBuffer);
         inputBuffer.clear();
-        l.sendValue(s);
+        l.sendValue(sendBuffer);
         return true;
     };
 
@@ -69,19 +73,12 @@ class AgentModel : public CSModelObject {
         SetState(CSInstanceState::IS_RUNNING);
         std::string s = l.getValue();
         if (s != "\n") {
-            try {
-                auto v = tools::myany::parseXMLString(s).or_else(
-                    [this](auto err) -> std::expected<std::any, tools::myany::parseError> {
-                        this->WriteLog(std::format("parse error: {}", err), 4);
-                        return CSValueMap{};
-                    });
-                outputBuffer = std::any_cast<CSValueMap>(std::move(v.value()));
-            } catch (rapidxml::parse_error &err) {
-                WriteLog(err.what(), 5);
-                WriteLog(s, 5);
-            } catch (std::bad_any_cast& err) {
-                WriteLog(err.what(), 5);
+            // parse in place into the reused output buffer
+            outputBuffer.clear();
+            if (auto ans = tools::myany::parseXMLStringViewInto(s, outputBuffer); !ans) {
+                WriteLog(std::format("parse error: {}", ans.error()), 4);
                 WriteLog(s, 5);
+                outputBuffer.clear();
             }
         }
         outputBuffer.emplace("ForceSideID", GetForceSideID());
@@ -96,6 +93,7 @@ class AgentModel : public CSModelObject {
     Link l;
     std::vector<std::any> inputBuffer;
     CSValueMap outputBuffer;
+    std::string sendBuffer;
 };
 
 extern "C" {
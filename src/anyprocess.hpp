@@ -15,8 +15,10 @@
 #pragma once
 
 #include <any>
+#include <functional>
 #include <string>
 #include <type_traits>
+#include <typeinfo>
 #include <unordered_map>
 #include <vector>
 
@@ -68,33 +70,35 @@ inline auto visit(Func &&func, Any &&v) {
     // func(std::string&&)
 
     // TODO: use if constexpr to identify if func can called on data in std::any
-    if (v.type() == typeid(double)) {
+    // type() is a virtual call through the any manager, query it once
+    const std::type_info &t = v.type();
+    if (t == typeid(double)) {
         return func(*std::any_cast<double>(&v));
-    } else if (v.type() == typeid(float)) {
+    } else if (t == typeid(float)) {
         return func(*std::any_cast<float>(&v));
-    } else if (v.type() == typeid(std::unordered_map<std::string, std::any>)) {
+    } else if (t == typeid(std::unordered_map<std::string, std::any>)) {
         return func(*std::any_cast<std::unordered_map<std::string, std::any>>(&v));
-    } else if (v.type() == typeid(std::vector<std::any>)) {
+    } else if (t == typeid(std::vector<std::any>)) {
         return func(*std::any_cast<std::vector<std::any>>(&v));
-    } else if (v.type() == typeid(std::string)) {
+    } else if (t == typeid(std::string)) {
         return func(*std::any_cast<std::string>(&v));
-    } else if (v.type() == typeid(int64_t)) {
+    } else if (t == typeid(int64_t)) {
         return func(*std::any_cast<int64_t>(&v));
-    } else if (v.type() == typeid(uint64_t)) {
+    } else if (t == typeid(uint64_t)) {
         return func(*std::any_cast<uint64_t>(&v));
-    } else if (v.type() == typeid(int32_t)) {
+    } else if (t == typeid(int32_t)) {
         return func(*std::any_cast<int32_t>(&v));
-    } else if (v.type() == typeid(uint32_t)) {
+    } else if (t == typeid(uint32_t)) {
         return func(*std::any_cast<uint32_t>(&v));
-    } else if (v.type() == typeid(bool)) {
+    } else if (t == typeid(bool)) {
         return func(*std::any_cast<bool>(&v));
-    } else if (v.type() == typeid(int8_t)) {
+    } else if (t == typeid(int8_t)) {
         return func(*std::any_cast<int8_t>(&v));
-    } else if (v.type() == typeid(uint8_t)) {
+    } else if (t == typeid(uint8_t)) {
         return func(*std::any_cast<uint8_t>(&v));
-    } else if (v.type() == typeid(int16_t)) {
+    } else if (t == typeid(int16_t)) {
         return func(*std::any_cast<int16_t>(&v));
-    } else if (v.type() == typeid(uint16_t)) {
+    } else if (t == typeid(uint16_t)) {
         return func(*std::any_cast<uint16_t>(&v));
     } else {
         if constexpr (std::is_constructible_v<decltype(func(*std::any_cast<double>(&v))),
@@ -0,0 +1,171 @@
+/**
+ * @file assembleconfig.hpp
+ * @author glutamate
+ * @brief parsed assemble.yml shared by all assembled model instances
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <expected>
+#include <format>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "datatransform.hpp"
+#include "dllop.hpp"
+
+/**
+ * @brief everything an assembled model needs from assemble.yml, with sub model dlls already resolved
+ *
+ */
+struct AssembleConfig {
+    struct SubModel {
+        std::string name;
+        std::string dllPath;
+        ModelDllInterface dll;
+        bool outputDataMovable = false;
+    };
+
+    std::string profileFile, traceFile, restartKey, sideFilter;
+    uint32_t logLevel = 0;
+    // run sub models concurrently as a flow nested in the engine's frame
+    bool parallel = false;
+    // (before, after): sub model `after` only ticks / outputs when `before` finished
+    std::vector<std::pair<std::string, std::string>> dependencies;
+    // ordered so every sub model comes after those it depends on
+    std::vector<SubModel> models;
+    // init: root->subs
+    // input: root->subs
+    // output: subs->subs, subs->root
+    TransformInfo init, input, output;
+};
+
+/**
+ * @brief parse assemble.yml in given directory and load all sub model dlls
+ *
+ * @param location directory contains assemble.yml, end with path separator; relative dll paths are based on it
+ * @return parsed config or error message
+ */
+inline std::expected<AssembleConfig, std::string> loadAssembleConfig(const std::string &location) {
+    AssembleConfig ret;
+    YAML::Node config;
+    try {
+        config = YAML::LoadFile(location + "assemble.yml");
+    } catch (YAML::Exception &err) {
+        return std::unexpected(
+            std::format("[AssembledModel] error when parsing {}assemble.yml: {}", location, err.what()));
+    }
+    for (auto &&model : config["models"]) {
+        auto name = model["model_name"].as<std::string>();
+        auto dllName = model["dll_name"].as<std::string>();
+        if (dllName.starts_with("./") || (!dllName.contains('/') && !dllName.contains('\\'))) {
+            dllName = location + dllName;
+        }
+        auto dll = loadDll(dllName);
+        if (!dll.has_value()) {
+            return std::unexpected(std::format("[AssembledModel] error when loading [{}]: {}", name, dll.error()));
+        }
+        ret.models.push_back({name, dllName, *dll, model["output_movable"].as<bool>(false)});
+    }
+    auto isSubModel = [&ret](const std::string &name) {
+        return std::ranges::any_of(ret.models, [&](auto &m) { return m.name == name; });
+    };
+    if (auto n = config["config"]) {
+        ret.profileFile = n["profile"].as<std::string>("");
+        ret.traceFile = n["profile_trace"].as<std::string>("");
+        ret.restartKey = n["restart_key"].as<std::string>("");
+        ret.sideFilter = n["side_filter"].as<std::string>("");
+        ret.logLevel = n["log_level"].as<uint32_t>(0);
+        if (auto p = n["parallel"]) {
+            ret.parallel = true;
+            for (auto &&dep : p["depends"]) {
+                auto after = dep.first.as<std::string>();
+                for (auto &&before : dep.second) {
+                    auto b = before.as<std::string>();
+                    if (!isSubModel(b) || !isSubModel(after)) {
+                        return std::unexpected(
+                            std::format("[AssembledModel] unknown sub model in parallel.depends: {} -> {}", b, after));
+                    }
+                    ret.dependencies.emplace_back(std::move(b), after);
+                }
+            }
+        }
+    }
+    // stable topological sort, so sub models without dependencies keep file order
+    std::vector<AssembleConfig::SubModel> sorted;
+    while (!ret.models.empty()) {
+        auto ready = std::ranges::find_if(ret.models, [&](auto &m) {
+            return std::ranges::none_of(ret.dependencies, [&](auto &dep) {
+                return dep.second == m.name && std::ranges::any_of(ret.models, [&](auto &o) {
+                    return o.name == dep.first;
+                });
+            });
+        });
+        if (ready == ret.models.end()) {
+            std::string names;
+            for (auto &&m : ret.models) {
+                names += names.empty() ? m.name : ", " + m.name;
+            }
+            return std::unexpected(
+                std::format("[AssembledModel] dependency cycle in parallel.depends among: {}", names));
+        }
+        sorted.push_back(std::move(*ready));
+        ret.models.erase(ready);
+    }
+    ret.models = std::move(sorted);
+    auto load = [&config](TransformInfo &tar, const std::string &name, auto check) {
+        for (auto &&rule : config[name.data()]) {
+            std::string from = rule["from"] ? rule["from"].as<std::string>() : "root";
+            std::string to = rule["to"] ? rule["to"].as<std::string>() : "root";
+            check(from, to);
+            for (auto &&value : rule["values"]) {
+                std::string srcName =
+                    value["name"] ? value["name"].as<std::string>() : value["src_name"].as<std::string>();
+                std::string dstName =
+                    value["name"] ? value["name"].as<std::string>() : value["dst_name"].as<std::string>();
+                tar.rules[from][srcName].push_back(TransformInfo::Action{
+                    .to = to,
+                    .dstName = dstName,
+                });
+            }
+        }
+    };
+    load(ret.init, "init_convert", [](auto &from, auto &to) { assert(from == "root"); });
+    load(ret.input, "input_convert", [](auto &from, auto &to) { assert(from == "root"); });
+    load(ret.output, "output_convert", [](auto &from, auto &to) { assert(from != "root"); });
+    return ret;
+}
+
+/**
+ * @brief process-wide cached version of loadAssembleConfig, parse yaml and load dlls only once for each location
+ *
+ * @attention failed loads are not cached
+ *
+ * @param location directory contains assemble.yml
+ * @return shared immutable config or error message
+ */
+inline std::expected<std::shared_ptr<const AssembleConfig>, std::string>
+loadAssembleConfigCached(const std::string &location) {
+    static std::mutex lock;
+    static std::unordered_map<std::string, std::shared_ptr<const AssembleConfig>> cache;
+    std::lock_guard<std::mutex> lck{lock};
+    if (auto it = cache.find(location); it != cache.end()) {
+        return it->second;
+    }
+    auto ans = loadAssembleConfig(location);
+    if (!ans) {
+        return std::unexpected(std::move(ans.error()));
+    }
+    auto [it, _] = cache.emplace(location, std::make_shared<const AssembleConfig>(std::move(*ans)));
+    return it->second;
+}
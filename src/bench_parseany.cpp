@@ -0,0 +1,81 @@
+#include <any>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+#include "parseany.hpp"
+
+namespace {
+
+// a map of n entities shaped like init values and agent outputs: ids, coordinates, an escaped name and a list
+std::string makeMessage(size_t n) {
+    std::string ret = "<c>";
+    for (size_t i = 0; i < n; ++i) {
+        auto id = std::to_string(i);
+        ret += "<e" + id + "><c>";
+        ret += "<ID><uint64_t>" + id + "</uint64_t></ID>";
+        ret += "<ForceSideID><uint16_t>" + std::to_string(i % 2) + "</uint16_t></ForceSideID>";
+        ret += "<longitude><double>120.123456789</double></longitude>";
+        ret += "<latitude><double>+30.5</double></latitude>";
+        ret += "<altitude><float>1500.25</float></altitude>";
+        ret += "<enableFire><bool>1</bool></enableFire>";
+        ret += "<name><string>car &amp; crew &#35;" + id + "</string></name>";
+        ret += "<path><li><double>1.5</double><double>-2.25</double><double>3e-3</double></li></path>";
+        ret += "</c></e" + id + ">";
+    }
+    ret += "</c>";
+    return ret;
+}
+
+// inputs the DOM path accepts beyond what toXML writes: duplicate names, attributes, comments and declarations
+const char *const edgeCases[] = {
+    "<c><a><int32_t>1</int32_t></a><a><int32_t>2</int32_t></a></c>",
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<!-- init value -->\n<c kind='entity'>"
+    "<ID unit=\"none\"><uint64_t>7</uint64_t></ID>"
+    "<!-- position --><longitude><double unit=\"deg\" >120.5</double></longitude>"
+    "<path><li><double>1</double><!-- next --><double>2</double></li></path>"
+    "<name><string>a<!-- b --></string></name></c>\n<!-- end -->",
+    "<!DOCTYPE c><c\t><f\n><c/></f></c>",
+};
+
+template <typename Fn> double usPerCall(Fn &&fn, size_t times) {
+    using namespace std::chrono;
+    auto begin = steady_clock::now();
+    for (size_t i = 0; i < times; ++i) {
+        fn();
+    }
+    return duration<double, std::micro>(steady_clock::now() - begin).count() / double(times);
+}
+
+} // namespace
+
+int main() {
+    using namespace tools::myany;
+    size_t parsed = 0;
+    for (auto &&msg : edgeCases) {
+        auto dom = parseXMLStringDOM(msg);
+        auto view = parseXMLStringView(msg);
+        std::unordered_map<std::string, std::any> into;
+        auto viewInto = parseXMLStringViewInto(msg, into);
+        if (!dom || !view || !viewInto || !anyEqual(*dom, *view) || !anyEqual(*dom, std::any{into})) {
+            std::cout << "results differ for " << msg << std::endl;
+            return 1;
+        }
+    }
+    for (size_t n : {1, 16, 256}) {
+        auto msg = makeMessage(n);
+        auto dom = parseXMLStringDOM(msg);
+        auto view = parseXMLStringView(msg);
+        if (!dom || !view || !anyEqual(*dom, *view)) {
+            std::cout << "results differ for " << n << " entities" << std::endl;
+            return 1;
+        }
+        size_t times = 100000 / n;
+        auto tDom = usPerCall([&] { parsed += parseXMLStringDOM(msg).has_value(); }, times);
+        auto tView = usPerCall([&] { parsed += parseXMLStringView(msg).has_value(); }, times);
+        std::cout << n << " entities, " << msg.size() << " bytes: dom " << tDom << " us, view " << tView
+                  << " us, speedup " << tDom / tView << std::endl;
+    }
+    return parsed == 0;
+}
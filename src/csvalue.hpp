@@ -0,0 +1,62 @@
+/**
+ * @file csvalue.hpp
+ * @author glutamate
+ * @brief hashable scalar value of a CSValueMap entry, used as key of latest topics
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <any>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include "anyprocess.hpp"
+
+namespace tools::myany {
+
+/**
+ * @brief scalar or string held by a std::any, values of different types never compare equal
+ *
+ */
+struct ScalarValue {
+    std::variant<bool, int8_t, uint8_t, int16_t, uint16_t, int32_t, uint32_t, int64_t, uint64_t, float, double,
+                 std::string>
+        data;
+
+    bool operator==(const ScalarValue &o) const = default;
+    size_t hash() const {
+        return std::visit([]<typename Ty>(const Ty &v) { return std::hash<Ty>{}(v); }, data);
+    }
+
+    /**
+     * @brief copy a scalar or string out of v, nullopt for empty values, maps, lists and other types
+     *
+     */
+    static std::optional<ScalarValue> fromAny(const std::any &v) {
+        struct Unknown {
+            std::optional<ScalarValue> operator()(const std::any &) const { return std::nullopt; }
+        };
+        return myany::visit<Unknown>(
+            []<typename Ty>(const Ty &x) -> std::optional<ScalarValue> {
+                if constexpr (std::is_same_v<Ty, std::unordered_map<std::string, std::any>> ||
+                              std::is_same_v<Ty, std::vector<std::any>>) {
+                    return std::nullopt;
+                } else {
+                    return ScalarValue{x};
+                }
+            },
+            v);
+    }
+};
+
+} // namespace tools::myany
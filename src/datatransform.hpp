@@ -2,13 +2,22 @@
 
 #include <any>
 #include <cassert>
+#include <memory>
 #include <span>
 #include <string>
 #include <unordered_map>
 
+struct TopicFilter;
+
 struct TransformInfo {
     struct Action {
         std::string to, dstName;
+        // receive every member of a delta topic, not only changed ones
+        bool snapshot = false;
+        // deliver only in frames divisible by period
+        uint32_t period = 1;
+        // deliver only messages passing this filter, if set
+        std::shared_ptr<const TopicFilter> where = {};
     };
     struct InputBuffer {
         // TODO: string_view
@@ -42,12 +51,7 @@ struct TransformInfo {
             if (it == rules.end()) {
                 continue;
             }
-            for (auto &&[name, value] : *data) {
-                auto it2 = it->second.find(name);
-                if (it2 == it->second.end()) {
-                    continue;
-                }
-                auto &actions = it2->second;
+            auto apply = [&](std::any &value, const std::vector<Action> &actions) {
                 assert(actions.size());
                 auto size = actions.size();
                 if (movable) {
@@ -60,6 +64,20 @@ struct TransformInfo {
                         callback(actions[i].to, actions[i].dstName, value);
                     }
                 }
+            };
+            // walk the smaller side, outputs often carry many fields nobody reads
+            if (it->second.size() < data->size()) {
+                for (auto &&[name, actions] : it->second) {
+                    if (auto it2 = data->find(name); it2 != data->end()) {
+                        apply(it2->second, actions);
+                    }
+                }
+            } else {
+                for (auto &&[name, value] : *data) {
+                    if (auto it2 = it->second.find(name); it2 != it->second.end()) {
+                        apply(value, it2->second);
+                    }
+                }
             }
         }
     }
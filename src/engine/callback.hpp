@@ -10,63 +10,259 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <any>
+#include <atomic>
 #include <format>
-#include <fstream>
-#include <mutex>
+#include <functional>
+#include <memory>
+#include <set>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "engine/logger.hpp"
 #include "parseany.hpp"
+#include "perthread.hpp"
+#include "taskflow/taskflow.hpp"
 
 using CSValueMap = std::unordered_map<std::string, std::any>;
 
 struct CallbackHandler {
-    size_t log_level = 0;
-    bool enable_log = true;
-    std::ofstream log_file = {};
-    // std::string curr_log_file = "None";
-    std::mutex callback_lock;
+    // heap allocated to keep handler movable
+    std::unique_ptr<AsyncLogger> logger = std::make_unique<AsyncLogger>();
+
+    /**
+     * @brief model which calls common callback, held by the callback of each model
+     *
+     */
+    struct Caller {
+        uint64_t ID;
+        // model type name when the model is created
+        std::string type;
+        // group type name of the model if any, direct topics of flattened sub models are published as their group
+        std::string group = {};
+        // number of commands issued by this caller; atomic since an assembled model forwards callbacks of its sub
+        // models running concurrently through one caller
+        std::atomic<uint64_t> seq = 0;
+
+        Caller(uint64_t ID, std::string type, std::string group = {})
+            : ID(ID), type(std::move(type)), group(std::move(group)) {}
+        Caller(const Caller &other)
+            : ID(other.ID), type(other.type), group(other.group), seq(other.seq.load(std::memory_order_relaxed)) {}
+        uint64_t next() { return seq.fetch_add(1, std::memory_order_relaxed); }
+    };
 
     struct CreateModelCommand {
+        uint64_t creator, seq;
+        // type of creator, tells apart models sharing an ID like flattened sub models of one instance
+        std::string creatorType;
         uint64_t ID;
         uint16_t sideID;
         CSValueMap param;
         std::string type;
     };
-    std::vector<CreateModelCommand> createModelCommands;
+
+    /**
+     * @brief topic published by DirectWriteTopic, routed by TopicManager::directTopics in collect phase
+     *
+     */
+    struct DirectTopicEvent {
+        uint64_t creator, seq;
+        std::string from;
+        std::string topicName;
+        CSValueMap params;
+    };
+
+    /**
+     * @brief wake up time asked by WakeAfter, used by event driven time advance
+     *
+     */
+    struct WakeRequest {
+        std::string type;
+        uint64_t ID;
+        // ms since the tick calling WakeAfter
+        double delay;
+    };
+
+    /**
+     * @brief run a flow of a model nested in the running frame, false if caller is not a worker of the engine; set
+     * by the engine
+     */
+    std::function<bool(tf::Taskflow &)> corun;
 
     void writeLog(std::string_view src, std::string_view msg, int32_t level) noexcept {
-        if (level < log_level || !enable_log || !log_file)
-            return;
-        std::unique_lock lock{callback_lock};
-        log_file << std::format("[{}-{}]: {}\n", src, level, msg);
+        logger->writeLog(src, msg, level);
+    }
+    /**
+     * @brief lazy version, makeMsg is only called when level passes
+     */
+    template <std::invocable Fn> void writeLog(std::string_view src, int32_t level, Fn &&makeMsg) noexcept {
+        logger->writeLog(src, level, std::forward<Fn>(makeMsg));
+    }
+
+    std::string commonCallBack(Caller &caller, const std::string &type,
+                               const std::unordered_map<std::string, std::any> &param) {
+        if (auto it = handlers().find(type); it != handlers().end()) {
+            return (this->*(it->second))(caller, type, param);
+        }
+        writeLog("Engine", 5, [&] {
+            return std::format("Unsupport Callback function call: {}({})", type,
+                               tools::myany::printCSValueMapToString(param));
+        });
+        return "";
     }
 
-    std::string commonCallBack(const std::string &type, const std::unordered_map<std::string, std::any> &param) {
-        // dynamic create entity
-        using namespace std::literals;
-        if (type == "CreateEntity"sv) {
-            try {
-                uint64_t ID = std::any_cast<uint64_t>(param.find("ID")->second);
-                uint16_t sideID = std::any_cast<uint16_t>(param.find("ForceSideID")->second);
-                std::string type = std::any_cast<std::string>(param.find("ModelID")->second);
-                std::unique_lock lock{callback_lock};
-                createModelCommands.push_back({ID, sideID, param, std::move(type)});
-            } catch (std::bad_any_cast &) {
-                writeLog("Engine",
-                         std::format("Data Type Mismatch while dynamic create entity: {}({})", type,
-                                     tools::myany::printCSValueMapToString(param)),
-                         5);
+    /**
+     * @brief set reply of GetConsumedFields, must not be called while models are running
+     *
+     * @param fields model type -> names in output read by any topic
+     */
+    void setConsumedFields(const std::unordered_map<std::string, std::set<std::string>> &fields) {
+        auto ret = std::make_shared<std::unordered_map<std::string, std::string>>();
+        for (auto &&[type, names] : fields) {
+            std::string joined;
+            for (auto &&name : names) {
+                if (!joined.empty()) {
+                    joined += ',';
+                }
+                joined += name;
             }
-        } else {
-            writeLog("Engine",
-                     std::format("Unsupport Callback function call: {}({})", type,
-                                 tools::myany::printCSValueMapToString(param)),
-                     5);
+            ret->emplace(type, std::move(joined));
+        }
+        consumedFields = std::move(ret);
+    }
+
+    /**
+     * @brief take all pending create commands, sorted by (creator ID, creator type, issue order)
+     *
+     * @attention only one thread may take at a time
+     */
+    std::vector<CreateModelCommand> takeCreateModelCommands() {
+        auto ret = createModelCommands->take();
+        std::ranges::stable_sort(ret, {}, [](const CreateModelCommand &c) {
+            return std::tie(c.creator, c.creatorType, c.seq);
+        });
+        return ret;
+    }
+    /**
+     * @brief take all topics published by DirectWriteTopic, sorted by (creator ID, publisher type, issue order)
+     *
+     * @attention only one thread may take at a time
+     */
+    std::vector<DirectTopicEvent> takeDirectTopicEvents() {
+        auto ret = directTopicEvents->take();
+        std::ranges::stable_sort(ret, {}, [](const DirectTopicEvent &e) { return std::tie(e.creator, e.from, e.seq); });
+        return ret;
+    }
+    /**
+     * @brief take all WakeAfter requests, in no particular order
+     *
+     * @attention only one thread may take at a time
+     */
+    std::vector<WakeRequest> takeWakeRequests() { return wakeRequests->take(); }
+
+  private:
+    using Handler = std::string (CallbackHandler::*)(Caller &, const std::string &, const CSValueMap &);
+    // callback name -> handler, resolved by one hash lookup instead of comparing with every name
+    static const std::unordered_map<std::string, Handler> &handlers() {
+        static const std::unordered_map<std::string, Handler> table{
+            {"CorunTaskflow", &CallbackHandler::corunTaskflow},
+            {"CreateEntity", &CallbackHandler::createEntity},
+            {"DirectWriteTopic", &CallbackHandler::directWriteTopic},
+            {"GetConsumedFields", &CallbackHandler::getConsumedFields},
+            {"WakeAfter", &CallbackHandler::wakeAfter},
+        };
+        return table;
+    }
+
+    template <typename Ty> static const Ty &get(const CSValueMap &param, const char *name) {
+        auto it = param.find(name);
+        if (it == param.end()) {
+            throw std::bad_any_cast{};
+        }
+        return std::any_cast<const Ty &>(it->second);
+    }
+
+    /**
+     * @brief run Taskflow (tf::Taskflow *) to end on workers of the engine, used by assembled models to run sub models
+     * concurrently without a pool of their own; replies "1" if run, "" if caller should run it some other way
+     */
+    std::string corunTaskflow(Caller &caller, const std::string &type, const CSValueMap &param) {
+        try {
+            auto flow = get<tf::Taskflow *>(param, "Taskflow");
+            return flow && corun && corun(*flow) ? "1" : "";
+        } catch (std::bad_any_cast &) {
+            writeLog("Engine", 5, [&] {
+                return std::format("Data Type Mismatch while corun taskflow: {}({})", type,
+                                   tools::myany::printCSValueMapToString(param));
+            });
+        }
+        return "";
+    }
+
+    std::string createEntity(Caller &caller, const std::string &type, const CSValueMap &param) {
+        try {
+            uint64_t ID = get<uint64_t>(param, "ID");
+            uint16_t sideID = get<uint16_t>(param, "ForceSideID");
+            std::string modelType = get<std::string>(param, "ModelID");
+            createModelCommands->push({caller.ID, caller.next(), caller.type, ID, sideID, param, std::move(modelType)});
+        } catch (std::bad_any_cast &) {
+            writeLog("Engine", 5, [&] {
+                return std::format("Data Type Mismatch while dynamic create entity: {}({})", type,
+                                   tools::myany::printCSValueMapToString(param));
+            });
+        }
+        return "";
+    }
+
+    std::string directWriteTopic(Caller &caller, const std::string &type, const CSValueMap &param) {
+        try {
+            directTopicEvents->push({caller.ID, caller.next(), caller.group.empty() ? caller.type : caller.group,
+                                     get<std::string>(param, "TopicName"),
+                                     get<CSValueMap>(param, "Params")});
+        } catch (std::bad_any_cast &) {
+            writeLog("Engine", 5, [&] {
+                return std::format("Data Type Mismatch while direct write topic: {}({})", type,
+                                   tools::myany::printCSValueMapToString(param));
+            });
         }
         return "";
     }
-};
\ No newline at end of file
+
+    /**
+     * @brief names of output fields of caller type read by any topic, joined by ','; empty if unknown, callers should
+     * then keep outputting everything
+     */
+    std::string getConsumedFields(Caller &caller, const std::string &type, const CSValueMap &param) {
+        if (!consumedFields) {
+            return "";
+        }
+        auto it = consumedFields->find(caller.type);
+        return it == consumedFields->end() ? "" : it->second;
+    }
+
+    std::string wakeAfter(Caller &caller, const std::string &type, const CSValueMap &param) {
+        try {
+            wakeRequests->push({caller.type, caller.ID, get<double>(param, "Delay")});
+        } catch (std::bad_any_cast &) {
+            writeLog("Engine", 5, [&] {
+                return std::format("Data Type Mismatch while wake after: {}({})", type,
+                                   tools::myany::printCSValueMapToString(param));
+            });
+        }
+        return "";
+    }
+
+    // model type -> reply of GetConsumedFields, set once scene is loaded
+    std::shared_ptr<const std::unordered_map<std::string, std::string>> consumedFields;
+    std::unique_ptr<tools::PerThreadStack<CreateModelCommand>> createModelCommands =
+        std::make_unique<tools::PerThreadStack<CreateModelCommand>>();
+    std::unique_ptr<tools::PerThreadStack<DirectTopicEvent>> directTopicEvents =
+        std::make_unique<tools::PerThreadStack<DirectTopicEvent>>();
+    std::unique_ptr<tools::PerThreadStack<WakeRequest>> wakeRequests =
+        std::make_unique<tools::PerThreadStack<WakeRequest>>();
+};
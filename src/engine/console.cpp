@@ -27,8 +27,20 @@ inline std::expected<void, std::string> allcfg(ConsoleApp &app, const std::vecto
     // std::cout << R"(allowed cfg:
     //     loglevel: u64,
     //     logfile: str,
+    //     logbinary: i8,
     //     enablelog: i8,
     //     drawrate: u64,
+    //     parallelload: i8,
+    //     scenecache: i8,
+    //     partition: i8,
+    //     batchgrain: f64,
+    //     replan: u64,
+    //     pipelined: i8,
+    //     pinworkers: i8,
+    //     workers: u64,
+    //     spin: u64,
+    //     inline: i8,
+    //     eventdriven: i8,
     //     dt: f64,
     // )" << std::endl;
     std::cout << "avaliable cfg: ";
@@ -67,37 +79,98 @@ inline std::expected<void, std::string> print(ConsoleApp &app, const std::vector
 
 inline std::expected<void, std::string> models(ConsoleApp &app, const std::vector<std::string_view> &line) {
     std::cout << "static models:" << std::endl;
-    for (auto &&[name, handle] : app.engine.mm.models) {
-        std::cout << std::format("    {2}::{0}[{1}]", name, handle.obj->GetID(), handle.obj->GetForceSideID())
+    for (auto &&m : app.engine.mm.models) {
+        std::cout << std::format("    {2}::{0}[{1}]", m.modelTypeName, m.handle.obj->GetID(),
+                                 m.handle.obj->GetForceSideID())
                   << std::endl;
     }
     std::cout << "dynamic models:" << std::endl;
-    for (auto &&[name, handle] : app.engine.mm.dynamicModels) {
-        std::cout << std::format("    {2}::{0}[{1}]", name, handle.obj->GetID(), handle.obj->GetForceSideID())
+    for (auto &&m : app.engine.mm.dynamicModels) {
+        std::cout << std::format("    {2}::{0}[{1}]", m.modelTypeName, m.handle.obj->GetID(),
+                                 m.handle.obj->GetForceSideID())
                   << std::endl;
     }
     return {};
 }
 
+inline std::expected<void, std::string> cost(ConsoleApp &app, const std::vector<std::string_view> &line) {
+    std::cout << "cost of static models (us):" << std::endl;
+    for (auto &&[key, c] : app.engine.costTable()) {
+        std::cout << std::format("    {}[{}] output: {:.1f} input: {:.1f} tick: {:.1f}", key.first, key.second,
+                                 c.output, c.input, c.tick)
+                  << std::endl;
+    }
+    std::cout << std::format("{} tasks per phase", app.engine.plan.groups.size()) << std::endl;
+    return {};
+}
+
+inline std::expected<void, std::string> savecost(ConsoleApp &app, const std::vector<std::string_view> &line) {
+    if (app.scene_file.empty()) {
+        return std::unexpected("no scene loaded");
+    }
+    return saveCostTable(app.engine.costTable(), app.costFile());
+}
+
 }; // namespace
 
 // TODO: reload file, store cfg / load cfg file
 
 std::map<std::string, ConsoleApp::Command, std::less<>> ConsoleApp::commandCallbacks{
     {"load", {1, load}},   {"l", {1, load}},      {"run", {1, run}},     {"r", {1, run}},   {"cfg", {0, allcfg}},
-    {"get", {1, showcfg}}, {"set", {2, editcfg}}, {"print", {0, print}}, {"p", {0, print}}, {"model", {0, models}}};
+    {"get", {1, showcfg}}, {"set", {2, editcfg}}, {"print", {0, print}}, {"p", {0, print}}, {"model", {0, models}},
+    {"cost", {0, cost}},   {"savecost", {0, savecost}}};
 
 void ConsoleApp::initCfg() {
-    cfg.listen("loglevel", [this](auto &arg) { engine.mm.callback.log_level = std::stoull(arg); });
-    cfg.listen("logfile", [this](auto &arg) { engine.mm.callback.log_file = std::ofstream(arg); });
-    cfg.listen("enablelog", [this](auto &arg) { engine.mm.callback.enable_log = std::stoi(arg); });
+    cfg.listen("loglevel", [this](auto &arg) { engine.mm.callback.logger->setLevel(std::stoi(arg)); });
+    cfg.listen("logfile", [this](auto &arg) { engine.mm.callback.logger->open(arg); });
+    cfg.listen("logbinary", [this](auto &arg) { engine.mm.callback.logger->setBinary(std::stoi(arg)); });
+    cfg.listen("enablelog", [this](auto &arg) { engine.mm.callback.logger->setEnable(std::stoi(arg)); });
     cfg.listen("drawrate", [this](auto &arg) { draw_rate = std::stoull(arg); });
+    cfg.listen("parallelload", [this](auto &arg) { parallel_load = std::stoi(arg); });
+    cfg.listen("scenecache", [this](auto &arg) { scene_cache = std::stoi(arg); });
+    cfg.listen("partition", [this](auto &arg) { engine.partition = std::stoi(arg); });
+    cfg.listen("batchgrain", [this](auto &arg) { engine.batchGrain = std::stod(arg); });
+    cfg.listen("replan", [this](auto &arg) { engine.replanPeriod = std::stoull(arg); });
+    cfg.listen("pipelined", [this](auto &arg) { engine.pipelined = std::stoi(arg); });
+    cfg.listen("pinworkers", [this](auto &arg) {
+        engine.pinWorkers = std::stoi(arg);
+        if (cfg_synced) {
+            engine.rebuildExecutor();
+        }
+    });
+    cfg.listen("workers", [this](auto &arg) {
+        engine.workerCount = std::stoull(arg);
+        if (cfg_synced) {
+            engine.rebuildExecutor();
+        }
+    });
+    cfg.listen("spin", [this](auto &arg) { engine.spinMicros = std::stoull(arg); });
+    cfg.listen("inline", [this](auto &arg) { engine.inlineMode = std::stoi(arg); });
+    cfg.listen("eventdriven", [this](auto &arg) { engine.eventDriven = std::stoi(arg); });
     cfg.listen("dt", [this](auto &arg) { engine.s.dt = std::stod(arg); });
 
     cfg.syncWithFile("engine.ini");
 
-    cfg.setValue("loglevel", std::to_string(engine.mm.callback.log_level));
-    cfg.setValue("enablelog", std::to_string(engine.mm.callback.enable_log));
+    cfg.setValue("loglevel", std::to_string(engine.mm.callback.logger->level()));
+    cfg.setValue("logbinary", std::to_string(engine.mm.callback.logger->isBinary()));
+    cfg.setValue("enablelog", std::to_string(engine.mm.callback.logger->isEnabled()));
     cfg.setValue("drawrate", std::to_string(draw_rate));
+    cfg.setValue("parallelload", std::to_string(parallel_load));
+    cfg.setValue("scenecache", std::to_string(scene_cache));
+    cfg.setValue("partition", std::to_string(engine.partition));
+    cfg.setValue("batchgrain", std::to_string(engine.batchGrain));
+    cfg.setValue("replan", std::to_string(engine.replanPeriod));
+    cfg.setValue("pipelined", std::to_string(engine.pipelined));
+    cfg.setValue("pinworkers", std::to_string(engine.pinWorkers));
+    cfg.setValue("workers", std::to_string(engine.workerCount));
+    cfg.setValue("spin", std::to_string(engine.spinMicros));
+    cfg.setValue("inline", std::to_string(engine.inlineMode));
+    cfg.setValue("eventdriven", std::to_string(engine.eventDriven));
     cfg.setValue("dt", std::to_string(engine.s.dt));
+
+    // executor options are applied once, the default executor already has one unpinned worker per core
+    if (engine.workerCount != 0 || engine.pinWorkers != 0) {
+        engine.rebuildExecutor();
+    }
+    cfg_synced = true;
 }
\ No newline at end of file
@@ -11,6 +11,7 @@
 #pragma once
 
 #include <expected>
+#include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iostream>
@@ -19,7 +20,10 @@
 #include "yaml-cpp/yaml.h"
 
 #include "engine/executionengine.hpp"
+#include "engine/flatten.hpp"
+#include "engine/scene.hpp"
 #include "config.hpp"
+#include "taskflow/algorithm/for_each.hpp"
 
 struct Scene {
     double x_lower = 0., x_upper = 0., y_lower = 0., y_upper = 0.;
@@ -142,53 +146,131 @@ struct ConsoleApp {
 
     std::expected<void, std::string> loadFile(const std::string &config_file) {
         engine.clear();
-        auto config = YAML::LoadFile(config_file);
-        for (auto &&n : config["model_types"]) {
+        auto scene = SceneDesc::load(config_file, scene_cache, [this](size_t n, const std::function<void(size_t)> &fn) {
+            forEachIndex(n, fn);
+        });
+        if (!scene) {
+            return std::unexpected(scene.error());
+        }
+        std::unordered_map<std::string, FlattenedType> flattened;
+        struct DllDesc {
+            const SceneDesc::ModelType &type;
+            std::expected<ModelDllInterface, std::string_view> dll = std::unexpected("not loaded");
+        };
+        std::vector<DllDesc> dlls;
+        for (auto &&type : scene->modelTypes) {
+            if (type.dynamic) {
+                engine.dynamicTypes.emplace(type.name);
+            }
+            if (type.flatten) {
+                // schedule sub models of assembled model directly
+                auto dir = type.assembleDir.empty() ? type.path.substr(0, type.path.find_last_of("/\\") + 1)
+                                                    : type.assembleDir;
+                if (!dir.empty() && !dir.ends_with('/') && !dir.ends_with('\\')) {
+                    dir += '/';
+                }
+                auto ans = FlattenedType::load(type.name, dir, engine.mm);
+                if (!ans) {
+                    return std::unexpected(ans.error());
+                }
+                flattened.emplace(type.name, std::move(*ans));
+                continue;
+            }
             // TODO: composed scene with relative file path
-            auto succ = engine.mm.loadDll(n["model_type_name"].as<std::string>(), n["dll_path"].as<std::string>(),
-                                          n["output_movable"].as<bool>(false));
-            if (!succ) {
-                return std::unexpected(succ.error());
+            dlls.push_back({type});
+        }
+        forEachIndex(dlls.size(), [&dlls](size_t i) { dlls[i].dll = ::loadDll(dlls[i].type.path); });
+        for (auto &&[type, dll] : dlls) {
+            if (!dll) {
+                return std::unexpected(std::string(dll.error()));
             }
+            engine.mm.registerDll(type.name, *dll, type.movable);
         }
-        for (auto &&n : config["models"]) {
-            auto type = n["model_type"].as<std::string>();
-            auto id = n["id"].as<uint64_t>();
-            auto sideID = n["side_id"].as<uint16_t>();
-            auto ans = tools::myany::parseXMLString(n["init_value"].as<std::string>());
-            if (!ans) {
-                return std::unexpected(
-                    std::format("error when parse \"{}\" : {}", n["init_value"].as<std::string>(), ans.error()));
-            }
-            if (ans.value().type() != typeid(CSValueMap)) {
-                return std::unexpected(
-                    std::format("error when parse \"{}\" : must be CSValueMap", n["init_value"].as<std::string>()));
-            }
-            auto value = std::any_cast<CSValueMap>(std::move(ans.value()));
-            value.emplace("ForceSideID", sideID);
-            value.emplace("ID", id);
-            if (auto ans = engine.mm.createModel(id, sideID, type, value, false); !ans) {
-                return std::unexpected(std::format("Exception When Model[{}]Init: {}", type, ans.error()));
+
+        // models are created and initialized one by one in file order, Init of a dll is not required to be thread-safe
+        for (auto &&desc : scene->models) {
+            desc.value.emplace("ForceSideID", desc.sideID);
+            desc.value.emplace("ID", desc.id);
+            if (auto it = flattened.find(desc.type); it != flattened.end()) {
+                if (auto ans = it->second.createInstance(engine.mm, desc.id, desc.sideID, desc.value); !ans) {
+                    return std::unexpected(ans.error());
+                }
+                continue;
+            }
+            if (auto ans = engine.mm.createModel(desc.id, desc.sideID, desc.type, desc.value, false); !ans) {
+                return std::unexpected(std::format("Exception When Model[{}]Init: {}", desc.type, ans.error()));
             }
         }
-        for (auto &&n : config["topics"]) {
-            TransformInfo trans;
-            auto from = n["from"].as<std::string>();
-            for (auto &&sub : n["subscribers"]) {
-                auto to = sub["to"].as<std::string>();
-                for (auto &&convert : sub["name_convert"]) {
-                    auto src = convert["name"].as<std::string>(convert["src_name"].as<std::string>(""));
-                    auto dst = convert["name"].as<std::string>(convert["dst_name"].as<std::string>(""));
-                    trans.rules[from][src].push_back({to, std::move(dst)});
+        for (auto &&t : scene->topics) {
+            std::unordered_map<std::string, std::shared_ptr<const TopicFilter>> filters;
+            for (auto &&[to, where] : t.where) {
+                auto filter = TopicFilter::compile(where);
+                if (!filter) {
+                    return std::unexpected(
+                        std::format("bad where of subscriber {} of topic from {}: {}", to, t.from, filter.error()));
                 }
+                filters.emplace(to, std::make_shared<const TopicFilter>(std::move(*filter)));
+            }
+            TransformInfo trans;
+            for (auto &&[to, src, dst, snapshot, period] : t.converts) {
+                auto filter = filters.find(to);
+                trans.rules[t.from][src].push_back(
+                    {to, dst, snapshot, period, filter == filters.end() ? nullptr : filter->second});
+            }
+            TopicManager::TopicInfo info{t.members, std::move(trans), t.delta, t.always, t.latest, t.key, t.period};
+            if (t.direct) {
+                // published by DirectWriteTopic only
+                engine.tm.directTopics[t.from].insert_or_assign(t.name, std::move(info));
+                continue;
+            }
+            engine.tm.topics[t.from].push_back(std::move(info));
+        }
+        if (!flattened.empty()) {
+            if (auto ans = flattenTopics(engine.tm.topics, engine.mm, flattened); !ans) {
+                return ans;
             }
-            engine.tm.topics[from].push_back(
-                TopicManager::TopicInfo{n["members"].as<std::vector<std::string>>(), std::move(trans)});
+            flattenDirectTopics(engine.tm.directTopics, flattened);
         }
         engine.buildGraph();
+        scene_file = config_file;
+        // plan by costs saved in last session if any, the scene is already built so a bad table is only skipped
+        if (std::filesystem::exists(costFile())) {
+            if (auto costs = loadCostTable(costFile())) {
+                engine.loadCostTable(*costs);
+            } else {
+                engine.mm.callback.writeLog("Engine", costs.error(), 4);
+            }
+        }
         return std::expected<void, std::string>();
     }
 
+    // measured costs are saved to "<scene>.cost.yml"
+    std::string costFile() const { return scene_file + ".cost.yml"; }
+
+    /**
+     * @brief call fn(i) for every i in [0, n), on engine executor if parallel_load is set
+     *
+     */
+    template <typename Fn> void forEachIndex(size_t n, Fn &&fn) {
+        if (!parallel_load || n < 2) {
+            for (size_t i = 0; i < n; ++i) {
+                fn(i);
+            }
+            return;
+        }
+        tf::Taskflow flow;
+        flow.for_each_index(size_t(0), n, size_t(1), std::forward<Fn>(fn));
+        engine.executor->run(flow).wait();
+    }
+
     ExecutionEngine engine = {};
     size_t draw_rate = 0;
+    // load dlls and parse init values concurrently, models are still initialized one by one
+    bool parallel_load = true;
+    // reuse precompiled "<scene>.cqc" next to scene file
+    bool scene_cache = true;
+    // path of loaded scene file
+    std::string scene_file;
+    // set after initCfg, later changes of executor options rebuild it immediately
+    bool cfg_synced = false;
 };
\ No newline at end of file
@@ -10,20 +10,33 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <any>
 #include <array>
+#include <atomic>
+#include <cmath>
+#include <deque>
 #include <expected>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
 #include <ranges>
 #include <set>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
 #include <vector>
 #include <chrono>
 
+#include "affinity.hpp"
+#include "csvalue.hpp"
 #include "datatransform.hpp"
 #include "dowithcatch.hpp"
 #include "engine/modelmanager.hpp"
+#include "engine/schedule.hpp"
+#include "engine/topicfilter.hpp"
 #include "taskflow/taskflow.hpp"
 
 using CSValueMap = std::unordered_map<std::string, std::any>;
@@ -43,6 +56,7 @@ struct TopicManager {
 
     void clear() {
         topics.clear();
+        directTopics.clear();
         dependenciesOfTarget.clear();
         // TODO: UB?
         buffer.~TopicBuffer();
@@ -52,6 +66,52 @@ struct TopicManager {
     struct TopicInfo {
         std::vector<std::string> members;
         TransformInfo trans;
+        // publish only members changed since last publish of the same model, plus `always`
+        bool delta = false;
+        std::vector<std::string> always = {};
+        // keep only the newest message of every value of member `key` in each collect buffer
+        bool latest = false;
+        std::string key = {};
+        // publish only in frames divisible by period, ignored by direct topics
+        uint32_t period = 1;
+        // targets with snapshot actions, they receive all members of a delta topic; filled in buildGraph
+        std::set<std::string> snapshotTargets = {};
+        // target -> period of its actions if not 1; filled in buildGraph
+        std::unordered_map<std::string, uint32_t> targetPeriods = {};
+        // target -> where of its actions if any; filled in buildGraph
+        std::unordered_map<std::string, const TopicFilter *> targetFilters = {};
+
+        struct Admission {
+            bool accepted;
+            const TopicFilter *filter;
+            // publisher values of self conditions of filter
+            std::vector<double> self;
+        };
+        /**
+         * @brief test constant conditions of filtered targets on publisher data, must be called before data is moved
+         *
+         * @return filtered target -> admission, unfiltered targets are not included
+         */
+        std::unordered_map<std::string_view, Admission> admit(const CSValueMap &data) const {
+            std::unordered_map<std::string_view, Admission> ret;
+            for (auto &&[target, filter] : targetFilters) {
+                Admission a{filter->test(data), filter->selfConditions.empty() ? nullptr : filter, {}};
+                a.accepted = a.accepted && filter->collectSelf(data, a.self);
+                ret.emplace(target, std::move(a));
+            }
+            return ret;
+        }
+        std::unordered_map<std::string, const TopicFilter *> getTargetFilters() const {
+            std::unordered_map<std::string, const TopicFilter *> ret;
+            for (auto &&acts : trans.rules | std::views::values | std::views::join | std::views::values) {
+                for (auto &&act : acts) {
+                    if (act.where) {
+                        ret.emplace(act.to, act.where.get());
+                    }
+                }
+            }
+            return ret;
+        }
         bool canAssembleFrom(const CSValueMap &data) const {
             for (auto &&name : members) {
                 if (!data.contains(name)) {
@@ -60,6 +120,28 @@ struct TopicManager {
             }
             return true;
         }
+        std::set<std::string> getSnapshotTargets() const {
+            std::set<std::string> ret;
+            for (auto &&acts : trans.rules | std::views::values | std::views::join | std::views::values) {
+                for (auto &&act : acts) {
+                    if (act.snapshot) {
+                        ret.emplace(act.to);
+                    }
+                }
+            }
+            return ret;
+        }
+        std::unordered_map<std::string, uint32_t> getTargetPeriods() const {
+            std::unordered_map<std::string, uint32_t> ret;
+            for (auto &&acts : trans.rules | std::views::values | std::views::join | std::views::values) {
+                for (auto &&act : acts) {
+                    if (act.period > 1) {
+                        ret.emplace(act.to, act.period);
+                    }
+                }
+            }
+            return ret;
+        }
         std::set<std::string> getTargets() const {
             std::set<std::string> ret;
             for (auto &&[k, v] : trans.rules) {
@@ -76,8 +158,44 @@ struct TopicManager {
     // src type -> sent topics
     using ModelTopics = std::unordered_map<std::string, std::vector<TopicInfo>>;
     ModelTopics topics;
+    // src type -> topic name -> topic, published only by DirectWriteTopic and never scanned in output phase
+    using DirectTopics = std::unordered_map<std::string, std::unordered_map<std::string, TopicInfo>>;
+    DirectTopics directTopics;
 
-    using ClassifiedModelOutput = std::unordered_map<std::string, std::vector<CSValueMap>>;
+    // values last sent by one model, index of topic in ModelTopics -> target -> member -> value; used by delta topics
+    struct PublishState {
+        std::vector<std::unordered_map<std::string, CSValueMap>> last;
+    };
+
+    // message delivered to SetInput, with publisher values of self conditions of where if any
+    struct TopicMessage : CSValueMap {
+        const TopicFilter *filter = nullptr;
+        std::vector<double> self = {};
+        bool acceptedBy(CSModelObject &receiver) const { return !filter || filter->testSelf(self, receiver); }
+    };
+    using ClassifiedModelOutput = std::unordered_map<std::string, std::vector<TopicMessage>>;
+
+    // message held between output and collect phase, with the key it is merged by if sent by a latest topic
+    struct InternalMessage {
+        CSValueMap data;
+        // set if sent by a latest topic
+        const TopicInfo *latest = nullptr;
+        tools::myany::ScalarValue key = {};
+        const TopicFilter *filter = nullptr;
+        std::vector<double> self = {};
+    };
+    using ClassifiedInternalOutput = std::unordered_map<std::string, std::vector<InternalMessage>>;
+
+    // (latest topic, key value) -> slot in collect buffer of one target
+    struct LatestKey {
+        const TopicInfo *topic;
+        tools::myany::ScalarValue key;
+        bool operator==(const LatestKey &) const = default;
+    };
+    struct LatestKeyHash {
+        size_t operator()(const LatestKey &k) const { return std::hash<const void *>{}(k.topic) ^ k.key.hash(); }
+    };
+    using LatestIndex = std::unordered_map<LatestKey, size_t, LatestKeyHash>;
 
     struct TopicBuffer {
         TopicBuffer() {
@@ -87,48 +205,176 @@ struct TopicManager {
         TopicBuffer(const TopicBuffer &) = delete;
         void operator=(const TopicBuffer &) = delete;
         // model_id(src) -> model_type_name(target) -> topics
-        std::vector<CacheLinePadding<ClassifiedModelOutput>> output_buffer = {};
-        std::vector<CacheLinePadding<ClassifiedModelOutput>> dyn_output_buffer = {};
+        std::vector<CacheLinePadding<ClassifiedInternalOutput>> output_buffer = {};
+        std::vector<CacheLinePadding<ClassifiedInternalOutput>> dyn_output_buffer = {};
+        // model_id(src) -> published state
+        std::vector<PublishState> publish_state = {};
+        std::unordered_map<const CSModelObject *, PublishState> dyn_publish_state = {};
         // model_type_name -> topics received by that model
         CacheLinePadding<ClassifiedModelOutput> buffer0, buffer1;
         CacheLinePadding<ClassifiedModelOutput> *topic_buffer = &buffer0;
         CacheLinePadding<ClassifiedModelOutput> *preparing_topic_buffer = &buffer1;
-        void swapBuffer() { std::swap(topic_buffer, preparing_topic_buffer); }
+        // model_type_name -> slots of latest topics in preparing buffer
+        std::unordered_map<std::string, LatestIndex> latest_index;
+        /**
+         * @brief add empty buffers of a target, all targets are added before running so buffers of different targets
+         * can be collected and swapped concurrently
+         *
+         */
+        void addTarget(const std::string &target) {
+            topic_buffer->try_emplace(target);
+            preparing_topic_buffer->try_emplace(target);
+            latest_index.try_emplace(target);
+        }
+        // publish the preparing buffer of a target
+        void swapTarget(const std::string &target) {
+            std::swap(topic_buffer->find(target)->second, preparing_topic_buffer->find(target)->second);
+        }
     } buffer;
 
     std::unordered_map<std::string, std::vector<size_t>> dependenciesOfTarget;
 
-    void dynamicTopicCollect(tf::Subflow &sbf) {
-        std::unordered_map<std::string_view, tf::Task> dependencies;
-        for (auto &&[target, topics] : *buffer.preparing_topic_buffer) {
-            dependencies[target] = sbf.emplace([&] { topics.clear(); });
-        }
-        for (auto &&output : buffer.dyn_output_buffer) {
-            for (auto &&[k, v] : output) {
-                // TODO: remove?
-                if (!buffer.preparing_topic_buffer->contains(k)) {
-                    (*buffer.preparing_topic_buffer)[k];
-                }
-                auto it = dependencies.find(k);
-                tf::Task t = sbf.emplace([&, &buffer{buffer}] {
-                    auto &target_buffer = buffer.preparing_topic_buffer->find(k)->second;
-                    target_buffer.insert_range(target_buffer.end(), std::move(v));
-                    v.clear();
-                });
-                if (it != dependencies.end()) {
-                    t.succeed(it->second);
-                    it->second = t;
-                } else {
-                    dependencies.emplace(k, t);
+    /**
+     * @brief names in GetOutput of each publisher type read by any topic: transformed, required or tested ones
+     *
+     */
+    std::unordered_map<std::string, std::set<std::string>> consumedFields() const {
+        std::unordered_map<std::string, std::set<std::string>> ret;
+        for (auto &&[type, list] : topics) {
+            auto &fields = ret[type];
+            for (auto &&topic : list) {
+                for (auto &&[from, srcs] : topic.trans.rules) {
+                    auto &tar = from == type ? fields : ret[from];
+                    for (auto &&src : srcs | std::views::keys) {
+                        tar.emplace(src);
+                    }
+                }
+                fields.insert(topic.members.begin(), topic.members.end());
+                fields.insert(topic.always.begin(), topic.always.end());
+                if (topic.latest) {
+                    fields.emplace(topic.key);
+                }
+                for (auto &&filter : topic.targetFilters | std::views::values) {
+                    for (auto &&c : filter->conditions) {
+                        fields.emplace(c.member);
+                    }
+                    for (auto &&c : filter->selfConditions) {
+                        fields.emplace(c.member);
+                    }
+                }
+            }
+        }
+        return ret;
+    }
+
+    /**
+     * @brief append a message to collect buffer, a message of latest topic is merged into the slot of its key instead
+     * if any, newer values and where state win
+     *
+     */
+    static void appendTopic(std::vector<TopicMessage> &target, LatestIndex &index, TopicMessage &&data,
+                            const TopicInfo *latest, tools::myany::ScalarValue &&key) {
+        if (latest) {
+            auto [it, inserted] = index.try_emplace(LatestKey{latest, std::move(key)}, target.size());
+            if (!inserted) {
+                auto &slot = target[it->second];
+                for (auto &&[k, v] : data) {
+                    slot.insert_or_assign(k, std::move(v));
                 }
+                // self conditions are tested against the newest publisher values
+                slot.filter = data.filter;
+                slot.self = std::move(data.self);
+                return;
             }
         }
+        target.push_back(std::move(data));
+    }
+
+    static void appendTopics(std::vector<TopicMessage> &target, LatestIndex &index,
+                             std::vector<InternalMessage> &&topics) {
+        target.reserve(target.size() + topics.size());
+        for (auto &&topic : topics) {
+            appendTopic(target, index,
+                        {std::move(topic.data), topic.filter, std::move(topic.self)},
+                        topic.latest, std::move(topic.key));
+        }
+        topics.clear();
     }
 
-    void staticTopicCollect(const std::string &target) {
+    /**
+     * @brief route topics published by DirectWriteTopic into preparing buffer, events of unknown topics or missing
+     * members are dropped
+     *
+     * @param events events in deterministic order
+     */
+    void directTopicCollect(std::vector<CallbackHandler::DirectTopicEvent> events) {
+        for (auto &&e : events) {
+            auto it = directTopics.find(e.from);
+            if (it == directTopics.end()) {
+                continue;
+            }
+            auto it2 = it->second.find(e.topicName);
+            if (it2 == it->second.end() || !it2->second.canAssembleFrom(e.params)) {
+                continue;
+            }
+            auto &topic = it2->second;
+            // taken before params are moved, messages without a scalar or string key are queued as usual
+            const TopicInfo *latest = nullptr;
+            tools::myany::ScalarValue key;
+            if (topic.latest) {
+                if (auto k = e.params.find(topic.key); k != e.params.end()) {
+                    if (auto v = tools::myany::ScalarValue::fromAny(k->second)) {
+                        latest = &topic;
+                        key = std::move(*v);
+                    }
+                }
+            }
+            auto admission = topic.admit(e.params);
+            std::unordered_map<std::string, TopicMessage> ret;
+            std::array<TransformInfo::InputBuffer, 1> input{{e.from, &e.params, true}};
+            topic.trans.transformWithCallback(
+                [&]<typename Ty>(const std::string &a, const std::string &b, Ty &&c) {
+                    auto it = ret.find(a);
+                    if (it == ret.end()) {
+                        TopicMessage msg;
+                        if (auto ad = admission.find(a); ad != admission.end()) {
+                            if (!ad->second.accepted) {
+                                return;
+                            }
+                            msg.filter = ad->second.filter;
+                            msg.self = ad->second.self;
+                        }
+                        it = ret.emplace(a, std::move(msg)).first;
+                    }
+                    it->second.emplace(b, std::forward<Ty>(c));
+                },
+                std::span{input});
+            for (auto &&[target, data] : ret) {
+                appendTopic((*buffer.preparing_topic_buffer)[target], buffer.latest_index[target], std::move(data),
+                            latest, tools::myany::ScalarValue{key});
+            }
+        }
+    }
+
+    /**
+     * @brief rebuild preparing buffer of a target from outputs of this frame, dynamic models first
+     *
+     * @param dynamic if outputs of dynamic models are collected, only set for targets in component 0
+     */
+    void collectTarget(const std::string &target, bool dynamic) {
         auto &target_buffer = buffer.preparing_topic_buffer->find(target)->second;
+        auto &index = buffer.latest_index.find(target)->second;
+        target_buffer.clear();
+        index.clear();
+        if (dynamic) {
+            for (auto &&output : buffer.dyn_output_buffer) {
+                if (auto it = output.find(target); it != output.end()) {
+                    appendTopics(target_buffer, index, std::move(it->second));
+                }
+            }
+        }
         auto it = dependenciesOfTarget.find(target);
-        if (it == dependenciesOfTarget.end()) [[unlikely]] {
+        if (it == dependenciesOfTarget.end()) {
             return;
         }
         for (size_t modelID : it->second) {
@@ -137,29 +383,193 @@ struct TopicManager {
             if (it == output.end()) {
                 continue;
             }
-            target_buffer.insert_range(target_buffer.end(), std::move(it->second));
-            it->second.clear();
+            appendTopics(target_buffer, index, std::move(it->second));
         }
     }
 };
 
+/**
+ * @brief pins worker i of an executor to i-th core of a list, so workers no longer migrate between cores
+ *
+ * @details tasks are not bound to workers: phases of one model may run on different workers, in lockstep mode its
+ * input always follows the collect barrier and runs wherever that task is picked up
+ *
+ */
+struct PinnedWorkers : tf::WorkerInterface {
+    std::vector<size_t> cores;
+    explicit PinnedWorkers(std::vector<size_t> cores) : cores(std::move(cores)) {}
+    void scheduler_prologue(tf::Worker &worker) override {
+        if (!cores.empty()) {
+            pinThisThread(cores[worker.id() % cores.size()]);
+        }
+    }
+    void scheduler_epilogue(tf::Worker &worker, std::exception_ptr ptr) override {}
+};
+
 struct ExecutionEngine {
     TopicManager tm = {};
     ModelManager mm = {};
     struct State {
         double dt = 100; //< deltatime, ms
-        size_t loop = 0;
         double fps = 0.;
     } s;
 
-    tf::Executor executor = tf::Executor{};
+    // heap allocated to be rebuilt with other options
+    std::unique_ptr<tf::Executor> executor = std::make_unique<tf::Executor>();
     tf::Taskflow frame = {};
 
+    ExecutionEngine() {
+        // flows of models join the running frame on the worker calling the model, instead of blocking it
+        mm.callback.corun = [this](tf::Taskflow &flow) {
+            if (executor->this_worker_id() < 0) {
+                return false;
+            }
+            executor->corun(flow);
+            return true;
+        };
+    }
+
+    // worker count of executor, 0 for hardware concurrency
+    size_t workerCount = 0;
+    // caller busy waits a run for spinMicros microseconds before sleeping, saves wake up latency of short runs
+    size_t spinMicros = 0;
+    // run frames on caller thread without executor, for small scenes run by many processes side by side
+    bool inlineMode = false;
+    // phases of plan groups in plan order, run by inline mode; tasks of frame call the same functors, so elements must
+    // not move
+    std::deque<std::function<void()>> inlineOutputs, inlineInputs, inlineTicks;
+
+    // 0: workers float between cores; 1: worker i is pinned to i-th core; 2: like 1, cores ordered by NUMA node so
+    // neighbouring workers share a node
+    int pinWorkers = 0;
+
+    /**
+     * @brief recreate executor by current options
+     *
+     * @attention must not be called while running
+     */
+    void rebuildExecutor() {
+        auto workers = workerCount != 0 ? workerCount : size_t(std::thread::hardware_concurrency());
+        std::shared_ptr<tf::WorkerInterface> wix;
+        if (pinWorkers != 0) {
+            std::vector<size_t> cores;
+            for (auto &&node : numaCores()) {
+                cores.insert(cores.end(), node.begin(), node.end());
+            }
+            if (pinWorkers == 1) {
+                std::ranges::sort(cores);
+            }
+            wix = std::make_shared<PinnedWorkers>(std::move(cores));
+        }
+        // old workers are joined before new ones start
+        executor.reset();
+        executor = std::make_unique<tf::Executor>(workers, std::move(wix));
+    }
+
+    /**
+     * @brief model types exchanging topics with each other, synchronized by their own collect barrier
+     *
+     * @details component 0 holds dynamic models, direct topics and everything when partition is off
+     */
+    struct Component {
+        std::vector<std::string> targets;
+        // frames left in this run
+        size_t loop = 0;
+        // frames collected since start, read in output phase to decimate topics
+        std::atomic<size_t> frame = 0;
+    };
+    // split models into components, so a component need not wait for models it never exchanges topics with
+    bool partition = false;
+    // types which may be created by CreateEntity, kept in component 0 with dynamic models
+    std::set<std::string> dynamicTypes;
+    // deque keeps addresses of atomic counters stable
+    std::deque<Component> components;
+    std::unordered_map<std::string, size_t> componentOfType;
+    // types of dynamic models found outside component 0, they are not run
+    std::set<std::string> skippedDynamicTypes;
+    // publisher type -> target types
+    std::map<std::string, std::set<std::string>> targetsOfType;
+    std::set<std::string> directTargets;
+
+    /**
+     * @brief frame counters of a model in pipelined mode, where models of one component may be in different frames
+     *
+     */
+    struct Clock {
+        // frames left in this run
+        size_t loop = 0;
+        // frames finished since start, read in output phase to decimate topics
+        std::atomic<size_t> frame = 0;
+    };
+    // overlap frames of models, a model waits only for buffers it reads or writes instead of its whole component
+    bool pipelined = false;
+    // pipelined when graph is built, kept by replanning
+    bool pipelinedFrame = false;
+    // static model id -> clock, used in pipelined mode
+    std::deque<Clock> clocks;
+    Clock dynClock;
+    // static model id -> component
+    std::vector<size_t> componentOfModel;
+
+    // static model id -> measured cost
+    std::vector<ModelCost> costs;
+    SchedulePlan plan;
+    // cheap models are batched into tasks of about batchGrain microseconds, 0 to disable
+    double batchGrain = 0.;
+    // frames between replanning by measured costs, 0 to plan only when scene is loaded
+    size_t replanPeriod = 0;
+
+    /**
+     * @brief wake up state of a static model in event driven mode, touched only by tasks of the model while running
+     *
+     */
+    struct Wake {
+        // frame the model ticks in even if no topic arrives
+        size_t due = 0;
+        // first frame not covered by last tick, next tick spans frames since then
+        size_t since = 0;
+        // ticked since last output, other models have nothing new to output
+        bool ticked = true;
+        // received topics or is due in this frame
+        bool active = false;
+        // publishes topics or direct topics, so its tick may send topics to be read in next frame
+        bool publishes = false;
+    };
+    // frames are skipped to the earliest frame a static model is due in, models without topics to read sleep until due
+    bool eventDriven = false;
+    // wakes are valid, reset when switched into event driven mode
+    bool eventStarted = false;
+    // frames passed since start including skipped ones, read by model tasks in event driven mode
+    size_t eventFrame = 0;
+    // static model id -> wake up state
+    std::vector<Wake> wakes;
+    // (model type, ID) -> static model id, to find the model asking WakeAfter
+    std::map<std::pair<std::string, uint64_t>, size_t> modelOfCaller;
+
     void clear() {
         frame.clear();
         mm = {};
         tm.clear();
         s = State{};
+        components.clear();
+        componentOfType.clear();
+        dynamicTypes.clear();
+        skippedDynamicTypes.clear();
+        targetsOfType.clear();
+        directTargets.clear();
+        clocks.clear();
+        dynClock.loop = 0;
+        dynClock.frame = 0;
+        componentOfModel.clear();
+        costs.clear();
+        plan = {};
+        eventStarted = false;
+        eventFrame = 0;
+        wakes.clear();
+        modelOfCaller.clear();
+        inlineOutputs.clear();
+        inlineInputs.clear();
+        inlineTicks.clear();
     };
 
     struct ModelOutputFunc {
@@ -167,10 +577,24 @@ struct ExecutionEngine {
         CSModelObject *obj;
         std::string model_type;
         bool movable;
-        TopicManager::ClassifiedModelOutput &ret;
+        TopicManager::ClassifiedInternalOutput &ret;
         std::vector<TopicManager::TopicInfo> *topic_list;
         bool no_output_topic;
+        bool publish_identity = false;
+        TopicManager::PublishState *state = nullptr;
+        // frame counter of component of the model
+        const std::atomic<size_t> *frame_counter = nullptr;
+        double *cost = nullptr;
+        // set for static models, gates output in event driven mode
+        Wake *wake = nullptr;
         void operator()() {
+            if (wake && self.eventDriven) {
+                if (!wake->ticked) {
+                    return;
+                }
+                wake->ticked = false;
+            }
+            CostTimer timer{cost};
             CSValueMap *model_output_ptr = nullptr;
             doWithCatch([&, obj{obj}] {
                 model_output_ptr = obj->GetOutput();
@@ -182,49 +606,170 @@ struct ExecutionEngine {
             if (no_output_topic || !model_output_ptr) {
                 return;
             }
+            if (publish_identity) {
+                addIdentity(*model_output_ptr);
+            }
             for (auto &&[n, v] : ret) {
                 // TODO:
                 v.clear();
             }
+            if (state) {
+                state->last.resize(topic_list->size());
+            }
+            auto frame = frame_counter->load(std::memory_order_relaxed);
             for (auto &&[cnt, topic] : std::views::enumerate(*topic_list)) {
-                if (!topic.canAssembleFrom(*model_output_ptr)) {
+                if (frame % topic.period != 0 || !topic.canAssembleFrom(*model_output_ptr)) {
                     continue;
                 }
+                // target -> output fields forwarded to it, compared with what that target received last
+                std::unordered_map<std::string_view, std::set<const std::any *>> forwards;
+                // taken before output is moved, messages without a scalar or string key are queued as usual
+                const TopicManager::TopicInfo *latest = nullptr;
+                tools::myany::ScalarValue key;
+                if (topic.latest) {
+                    if (auto k = model_output_ptr->find(topic.key); k != model_output_ptr->end()) {
+                        if (auto v = tools::myany::ScalarValue::fromAny(k->second)) {
+                            latest = &topic;
+                            key = std::move(*v);
+                        }
+                    }
+                }
+                auto admission = topic.targetFilters.empty() ? decltype(topic.admit(*model_output_ptr)){}
+                                                             : topic.admit(*model_output_ptr);
                 std::array<TransformInfo::InputBuffer, 1> buffer{
                     {model_type, model_output_ptr, (cnt == topic_list->size() - 1) ? movable : false}};
                 // marks.data.clear();
                 topic.trans.transformWithCallback(
                     [&, marks{std::set<std::string_view>{}}]<typename Ty>(const std::string &a, const std::string &b,
                                                                           Ty &&c) mutable {
+                        auto ad = admission.find(a);
+                        if (ad != admission.end() && !ad->second.accepted) {
+                            return;
+                        }
+                        if (!topic.targetPeriods.empty()) {
+                            auto p = topic.targetPeriods.find(a);
+                            if (p != topic.targetPeriods.end() && frame % p->second != 0) {
+                                return;
+                            }
+                        }
+                        // snapshot targets get every member on every publish, changed or not
+                        if (topic.delta && state && !topic.snapshotTargets.contains(a)) {
+                            // compared once the target is known to receive the topic, so values it never got are
+                            // not remembered as sent
+                            auto [fw, first] = forwards.try_emplace(a);
+                            if (first) {
+                                diff(topic, a, state->last[cnt][a], *model_output_ptr, fw->second);
+                            }
+                            if (!fw->second.contains(&c)) {
+                                return;
+                            }
+                        }
                         if (!marks.contains(a)) {
                             marks.emplace(a);
-                            ret[a].emplace_back();
+                            if (ad != admission.end()) {
+                                ret[a].push_back({{}, latest, key, ad->second.filter, ad->second.self});
+                            } else {
+                                ret[a].push_back({{}, latest, key});
+                            }
+                        }
+                        ret.find(a)->second.back().data.emplace(b, std::forward<Ty>(c));
+                        if constexpr (std::is_rvalue_reference_v<Ty &&>) {
+                            // a moved from any is not guaranteed empty, diff and addIdentity rely on it
+                            c.reset();
                         }
-                        ret.find(a)->second.back().emplace(b, std::forward<Ty>(c));
                     },
                     std::span{buffer});
             }
         }
+        /**
+         * @brief compare output with values of a delta topic last sent to one target and remember changed ones
+         *
+         * @param forward set to fields to forward: changed fields and present `always` fields, left empty if no field
+         * changed, then the target does not receive the topic at all
+         */
+        void diff(const TopicManager::TopicInfo &topic, const std::string &target, CSValueMap &last,
+                  const CSValueMap &output, std::set<const std::any *> &forward) {
+            auto rules = topic.trans.rules.find(model_type);
+            if (rules == topic.trans.rules.end()) {
+                return;
+            }
+            for (auto &&[name, actions] : rules->second) {
+                if (std::ranges::none_of(actions, [&](auto &&action) { return action.to == target; })) {
+                    continue;
+                }
+                auto it = output.find(name);
+                // moved out in last frame and not refilled is seen as unchanged
+                if (it == output.end() || !it->second.has_value()) {
+                    continue;
+                }
+                if (auto old = last.find(name); old == last.end() || !tools::myany::anyEqual(old->second, it->second)) {
+                    last.insert_or_assign(name, it->second);
+                    forward.emplace(&it->second);
+                }
+            }
+            if (forward.empty()) {
+                return;
+            }
+            for (auto &&name : topic.always) {
+                if (auto it = output.find(name); it != output.end()) {
+                    forward.emplace(&it->second);
+                }
+            }
+        }
+        void addIdentity(CSValueMap &output) {
+            // output may be moved from in last frame, so refill empty values too
+            auto set = [&output]<typename Ty>(const char *name, Ty &&value) {
+                if (auto it = output.find(name); it == output.end() || !it->second.has_value()) {
+                    output.insert_or_assign(name, std::forward<Ty>(value));
+                }
+            };
+            set("ForceSideID", obj->GetForceSideID());
+            set("ModelID", obj->GetModelID());
+            set("InstanceName", obj->GetInstanceName());
+            set("ID", obj->GetID());
+            set("State", uint16_t(obj->GetState()));
+        }
     };
 
     struct ModelInputFunc {
         ExecutionEngine &self;
         CSModelObject *obj;
         std::string model_type;
+        std::string group_type = {};
+        double *cost = nullptr;
+        // set for static models, marks model active in event driven mode
+        Wake *wake = nullptr;
         void operator()() {
-            if (auto it = self.tm.buffer.topic_buffer->find(model_type); it != self.tm.buffer.topic_buffer->end()) {
+            CostTimer timer{cost};
+            size_t delivered = input(model_type);
+            if (!group_type.empty()) {
+                delivered += input(group_type);
+            }
+            if (wake) {
+                wake->active = delivered != 0 || wake->due <= self.eventFrame;
+            }
+        }
+        // return count of messages delivered
+        size_t input(const std::string &type) {
+            size_t delivered = 0;
+            if (auto it = self.tm.buffer.topic_buffer->find(type); it != self.tm.buffer.topic_buffer->end()) {
                 for (auto &&v : it->second) {
+                    if (!v.acceptedBy(*obj)) {
+                        continue;
+                    }
+                    delivered++;
                     doWithCatch([&] {
                         obj->SetInput(v);
                     }).or_else([&, this](const std::string &err) -> std::expected<void, std::string> {
-                        self.mm.callback.writeLog("Engine",
-                                                  std::format("Exception When Model[{}] Input: {}\n{}", model_type, err,
-                                                              tools::myany::printCSValueMapToString(v)),
-                                                  5);
+                        self.mm.callback.writeLog("Engine", 5, [&] {
+                            return std::format("Exception When Model[{}] Input: {}\n{}", model_type, err,
+                                               tools::myany::printCSValueMapToString(v));
+                        });
                         return {};
                     });
                 }
             }
+            return delivered;
         }
     };
 
@@ -232,9 +777,24 @@ struct ExecutionEngine {
         ExecutionEngine &self;
         CSModelObject *obj;
         std::string model_type;
+        double *cost = nullptr;
+        // set for static models, gates tick and stretches its step over skipped frames in event driven mode
+        Wake *wake = nullptr;
         void operator()() {
+            double dt = self.s.dt;
+            if (wake && self.eventDriven) {
+                if (!wake->active) {
+                    return;
+                }
+                dt *= double(self.eventFrame + 1 - wake->since);
+                wake->since = self.eventFrame + 1;
+                // tick in next frame unless WakeAfter asks otherwise
+                wake->due = self.eventFrame + 1;
+                wake->ticked = true;
+            }
+            CostTimer timer{cost};
             doWithCatch([&] {
-                obj->Tick(self.s.dt);
+                obj->Tick(dt);
             }).or_else([this](const std::string &err) -> std::expected<void, std::string> {
                 self.mm.callback.writeLog("Engine", std::format("Exception When Model[{}] Tick: {}", model_type, err),
                                           5);
@@ -243,130 +803,642 @@ struct ExecutionEngine {
         }
     };
 
+    /**
+     * @brief group model types into components by topics between them, see Component
+     *
+     * @param targets publisher type -> target types
+     */
+    void buildComponents(const std::map<std::string, std::set<std::string>> &targets) {
+        // union find over type names, node 0 stands for component 0
+        std::unordered_map<std::string, size_t> node;
+        std::vector<size_t> parent{0};
+        auto id = [&](const std::string &type) {
+            auto [it, inserted] = node.try_emplace(type, parent.size());
+            if (inserted) {
+                parent.push_back(parent.size());
+            }
+            return it->second;
+        };
+        auto find = [&](size_t x) {
+            while (parent[x] != x) {
+                x = parent[x] = parent[parent[x]];
+            }
+            return x;
+        };
+        auto unite = [&](size_t a, size_t b) {
+            a = find(a), b = find(b);
+            // smaller root wins, so node 0 stays root of its component
+            parent[std::max(a, b)] = std::min(a, b);
+        };
+
+        std::set<std::string> staticTypes;
+        for (auto &&m : mm.models) {
+            staticTypes.emplace(m.modelTypeName);
+            if (!m.groupTypeName.empty()) {
+                unite(id(m.modelTypeName), id(m.groupTypeName));
+            }
+        }
+        for (auto &&[from, tars] : targets) {
+            for (auto &&tar : tars) {
+                unite(id(from), id(tar));
+            }
+            // published by dynamic models only
+            if (!staticTypes.contains(from)) {
+                unite(0, id(from));
+            }
+        }
+        // direct topics are collected by one task
+        for (auto &&[from, list] : tm.directTopics) {
+            unite(0, id(from));
+            for (auto &&topic : list | std::views::values) {
+                for (auto &&tar : topic.getTargets()) {
+                    unite(0, id(tar));
+                }
+            }
+        }
+        for (auto &&type : dynamicTypes) {
+            unite(0, id(type));
+        }
+        if (!partition) {
+            for (auto &&n : node | std::views::values) {
+                unite(0, n);
+            }
+        }
+
+        // number components in order of first appearance, component 0 first
+        std::unordered_map<size_t, size_t> componentOfRoot{{0, 0}};
+        components.emplace_back();
+        for (auto &&[type, n] : node) {
+            auto [it, inserted] = componentOfRoot.try_emplace(find(n), components.size());
+            if (inserted) {
+                components.emplace_back();
+            }
+            componentOfType.emplace(type, it->second);
+        }
+        mm.callback.writeLog("Engine", std::format("{} model types in {} components", node.size(), components.size()),
+                             2);
+    }
+
+    /**
+     * @brief if dynamic models of a type run in component 0, others are skipped with a warning once
+     *
+     * @attention only called from dynamic output task
+     */
+    bool runsWithDynamicModels(const std::string &type) {
+        auto it = componentOfType.find(type);
+        if (it == componentOfType.end() || it->second == 0) {
+            return true;
+        }
+        if (skippedDynamicTypes.emplace(type).second) {
+            mm.callback.writeLog("Engine",
+                                 std::format("dynamic models of type {} are not run: topics of the type are collected "
+                                             "apart from dynamic models, mark it dynamic in model_types",
+                                             type),
+                                 4);
+        }
+        return false;
+    }
+
+    /**
+     * @brief analyze topics and prepare buffers, then build frame graph by costs known so far
+     *
+     */
     void buildGraph() {
-        std::map<std::string, std::set<std::string>> targets;
         for (auto &&[model_type, topics] : tm.topics) {
             for (auto &&topic : topics) {
-                targets[model_type].merge(topic.getTargets());
+                targetsOfType[model_type].merge(topic.getTargets());
+                topic.snapshotTargets = topic.getSnapshotTargets();
+                topic.targetPeriods = topic.getTargetPeriods();
+                topic.targetFilters = topic.getTargetFilters();
             }
         }
 
-        auto collect_task = frame.emplace([this](tf::Subflow &sbf) {
-            // tm.topicCollect(sbf);
-            tm.buffer.swapBuffer();
-            s.loop--;
-        });
-        collect_task.name("collect output");
+        // answered through GetConsumedFields callback
+        mm.callback.setConsumedFields(tm.consumedFields());
 
-        auto dyn_collector = frame.emplace([this](tf::Subflow &sbf) { tm.dynamicTopicCollect(sbf); });
-        dyn_collector.precede(collect_task).name("collect topic for dyn model");
-        std::unordered_map<std::string, tf::Task> collector;
-        for (auto &&type : targets | std::views::values | std::views::join) {
-            if (collector.contains(type)) {
+        for (auto &&topic : tm.directTopics | std::views::values | std::views::join | std::views::values) {
+            directTargets.merge(topic.getTargets());
+            topic.targetFilters = topic.getTargetFilters();
+        }
+        for (auto &&type : directTargets) {
+            tm.buffer.addTarget(type);
+        }
+        for (auto &&type : targetsOfType | std::views::values | std::views::join) {
+            tm.buffer.addTarget(type);
+        }
+
+        buildComponents(targetsOfType);
+        for (auto &&type : *tm.buffer.topic_buffer | std::views::keys) {
+            components[componentOfType.at(type)].targets.push_back(type);
+        }
+
+        tm.buffer.output_buffer.resize(mm.models.size());
+        tm.buffer.publish_state.resize(mm.models.size());
+        costs.resize(mm.models.size());
+        wakes.resize(mm.models.size());
+        for (auto &&[model_id, model_entity] : std::views::enumerate(mm.models)) {
+            auto &group = model_entity.groupTypeName;
+            wakes[model_id].publishes = tm.topics.contains(model_entity.modelTypeName) ||
+                                        tm.directTopics.contains(model_entity.modelTypeName) ||
+                                        (!group.empty() && tm.directTopics.contains(group));
+            modelOfCaller.emplace(std::pair{model_entity.modelTypeName, model_entity.handle.obj->GetID()}, model_id);
+            clocks.emplace_back();
+            componentOfModel.push_back(componentOfType.at(model_entity.modelTypeName));
+            for (auto &&target : targetsOfType[model_entity.modelTypeName]) {
+                tm.dependenciesOfTarget[target].emplace_back(model_id);
+            }
+        }
+
+        pipelinedFrame = pipelined;
+        buildFrame(SchedulePlan::make(costs, componentOfModel, batchGrain));
+    }
+
+    /**
+     * @brief rebuild frame graph if costs measured since last plan lead to a different plan
+     *
+     * @attention must not be called while running
+     */
+    void replan() {
+        if (auto p = SchedulePlan::make(costs, componentOfModel, batchGrain); p != plan) {
+            buildFrame(std::move(p));
+        }
+    }
+
+    /**
+     * @brief costs of static models, to be saved with scene
+     *
+     */
+    CostTable costTable() const {
+        CostTable ret;
+        for (auto &&[m, cost] : std::views::zip(mm.models, costs)) {
+            ret.insert_or_assign({m.modelTypeName, m.handle.obj->GetID()}, cost);
+        }
+        return ret;
+    }
+
+    /**
+     * @brief take saved costs of models in table and replan, costs of other models are kept
+     *
+     */
+    void loadCostTable(const CostTable &table) {
+        for (auto &&[m, cost] : std::views::zip(mm.models, costs)) {
+            if (auto it = table.find(std::pair{m.modelTypeName, m.handle.obj->GetID()}); it != table.end()) {
+                cost = it->second;
+            }
+        }
+        replan();
+    }
+
+    // run a phase of a dynamic model as a subflow task, or right now if sbf is null
+    template <typename Func> static void spawn(tf::Subflow *sbf, Func &&func) {
+        if (sbf) {
+            sbf->emplace(std::forward<Func>(func));
+        } else {
+            func();
+        }
+    }
+
+    /**
+     * @brief remove killed and create requested dynamic models, then output all of them
+     *
+     */
+    void dynamicOutput(tf::Subflow *sbf, const std::atomic<size_t> *frame_counter) {
+        // remove useless model
+        mm.destoryKilledModel();
+        // create model
+        mm.createDynamicModel();
+        // output
+        tm.buffer.dyn_output_buffer.resize(mm.dynamicModels.size());
+        // keep states of alive models only, addresses of destroyed models may be reused
+        decltype(tm.buffer.dyn_publish_state) states;
+        for (auto &&data : mm.dynamicModels) {
+            if (auto node = tm.buffer.dyn_publish_state.extract(data.handle.obj)) {
+                states.insert(std::move(node));
+            } else {
+                states.emplace(data.handle.obj, TopicManager::PublishState{});
+            }
+        }
+        tm.buffer.dyn_publish_state = std::move(states);
+        for (auto &&[idx, data] : std::views::enumerate(mm.dynamicModels)) {
+            if (!runsWithDynamicModels(data.modelTypeName)) {
                 continue;
             }
-            tf::Task sub_collect_task = frame.emplace([this, type] { tm.staticTopicCollect(type); });
-            sub_collect_task.succeed(dyn_collector).precede(collect_task).name("collect topic for " + type);
+            auto it = tm.topics.find(data.modelTypeName);
+            bool no_output = (it == tm.topics.end());
+            spawn(sbf, ModelOutputFunc{*this, data.handle.obj, data.modelTypeName, data.handle.outputDataMovable,
+                                       tm.buffer.dyn_output_buffer[idx], no_output ? nullptr : &it->second, no_output,
+                                       data.publishIdentity, &tm.buffer.dyn_publish_state.find(data.handle.obj)->second,
+                                       frame_counter});
+        }
+    }
 
-            tm.buffer.topic_buffer->emplace(type, TopicManager::ClassifiedModelOutput::mapped_type{});
-            tm.buffer.preparing_topic_buffer->emplace(type, TopicManager::ClassifiedModelOutput::mapped_type{});
-            collector.emplace(type, sub_collect_task);
+    void dynamicInput(tf::Subflow *sbf) {
+        for (auto &&m : mm.dynamicModels) {
+            if (!skippedDynamicTypes.contains(m.modelTypeName)) {
+                spawn(sbf, ModelInputFunc{*this, m.handle.obj, m.modelTypeName, m.groupTypeName});
+            }
         }
+    }
 
-        std::unordered_map<std::string, std::vector<tf::Task>> output_tasks;
+    void dynamicTick(tf::Subflow *sbf) {
+        for (auto &&m : mm.dynamicModels) {
+            if (!skippedDynamicTypes.contains(m.modelTypeName)) {
+                spawn(sbf, ModelTickFunc{*this, m.handle.obj, m.modelTypeName});
+            }
+        }
+    }
 
-        // dynamic tasks
-        auto dyn_output_task = frame.emplace([this](tf::Subflow &sbf) {
-            // remove useless model
-            mm.destoryKilledModel();
-            // create model
-            mm.createDynamicModel();
-            // output
-            tm.buffer.dyn_output_buffer.resize(mm.dynamicModels.size());
-            for (auto &&[idx, data] : std::views::enumerate(mm.dynamicModels)) {
-                auto it = tm.topics.find(data.modelTypeName);
-                bool no_output = (it == tm.topics.end());
-                sbf.emplace(ModelOutputFunc{*this, data.handle.obj, data.modelTypeName, data.handle.outputDataMovable,
-                                            tm.buffer.dyn_output_buffer[idx], no_output ? nullptr : &it->second,
-                                            no_output});
+    // run functors of a group one by one in a task
+    template <typename Func> static auto runAll(std::vector<Func> fns) {
+        return [fns = std::move(fns)]() mutable {
+            for (auto &&f : fns) {
+                f();
+            }
+        };
+    }
+
+    /**
+     * @brief create tasks of a frame, static models of a group share their output, input and tick tasks
+     *
+     */
+    void buildFrame(SchedulePlan p) {
+        plan = std::move(p);
+        frame.clear();
+        inlineOutputs.clear();
+        inlineInputs.clear();
+        inlineTicks.clear();
+
+        // task publishing preparing buffer of each target: collect task of its component, or in pipelined mode a swap
+        // task of its own, or the task collecting direct topics for their targets
+        std::unordered_map<std::string, tf::Task> publisher;
+        std::vector<tf::Task> collect_tasks;
+        std::optional<tf::Task> direct_task;
+        if (!pipelinedFrame) {
+            for (auto &&[idx, comp] : std::views::enumerate(components)) {
+                auto collect_task = frame.emplace([this, &comp, idx] {
+                    if (idx == 0) {
+                        tm.directTopicCollect(mm.callback.takeDirectTopicEvents());
+                    }
+                    for (auto &&type : comp.targets) {
+                        tm.buffer.swapTarget(type);
+                    }
+                    comp.frame.fetch_add(1, std::memory_order_relaxed);
+                    comp.loop--;
+                });
+                collect_task.name(std::format("collect output of component {}", idx));
+                collect_tasks.push_back(collect_task);
+                for (auto &&type : comp.targets) {
+                    publisher.emplace(type, collect_task);
+                }
+            }
+        } else {
+            if (!directTargets.empty()) {
+                direct_task = frame.emplace([this] {
+                    tm.directTopicCollect(mm.callback.takeDirectTopicEvents());
+                    for (auto &&type : directTargets) {
+                        tm.buffer.swapTarget(type);
+                    }
+                });
+                direct_task->name("collect direct topics");
+                for (auto &&type : directTargets) {
+                    publisher.emplace(type, *direct_task);
+                }
+            }
+            for (auto &&type : *tm.buffer.topic_buffer | std::views::keys) {
+                if (!directTargets.contains(type)) {
+                    auto swap_task = frame.emplace([this, type] { tm.buffer.swapTarget(type); });
+                    publisher.emplace(type, swap_task.name("publish topic for " + type));
+                }
             }
+        }
+        // distinct publishers of some targets
+        auto publishersOf = [&](auto &&types) {
+            std::vector<tf::Task> ret;
+            for (auto &&type : types) {
+                auto it = publisher.find(type);
+                if (it != publisher.end() && std::ranges::find(ret, it->second) == ret.end()) {
+                    ret.push_back(it->second);
+                }
+            }
+            return ret;
+        };
+
+        std::unordered_map<std::string, tf::Task> collector;
+        for (auto &&[idx, comp] : std::views::enumerate(components)) {
+            for (auto &&type : comp.targets) {
+                tf::Task sub_collect_task = frame.emplace([this, type, dynamic = idx == 0] {
+                    tm.collectTarget(type, dynamic);
+                });
+                sub_collect_task.precede(publisher.at(type)).name("collect topic for " + type);
+                collector.emplace(type, sub_collect_task);
+            }
+        }
+
+        // dynamic tasks, run in component 0
+        auto &dyn_comp = components.front();
+        const std::atomic<size_t> *dyn_frame = pipelinedFrame ? &dynClock.frame : &dyn_comp.frame;
+        auto dyn_output_task = frame.emplace([this, dyn_frame](tf::Subflow &sbf) {
+            dynamicOutput(&sbf, dyn_frame);
             sbf.join();
         });
-        dyn_output_task.name(std::format("dynamic::output")).precede(dyn_collector);
+        dyn_output_task.name(std::format("dynamic::output"));
+        // dynamic models may read and write any target of component 0
+        auto dyn_publishers = pipelinedFrame ? publishersOf(dyn_comp.targets) : std::vector{collect_tasks.front()};
+        for (auto &&task : dyn_publishers) {
+            dyn_output_task.precede(task);
+        }
+        for (auto &&type : dyn_comp.targets) {
+            dyn_output_task.precede(collector.at(type));
+        }
 
         auto dyn_init_task = frame.emplace([] { return 0; }).name("dynamic::start loop").precede(dyn_output_task);
 
         auto dyn_input_task = frame.emplace([this](tf::Subflow &sbf) {
-            for (auto &&[model_type, handle] : mm.dynamicModels) {
-                sbf.emplace(ModelInputFunc{*this, handle.obj, model_type});
-            }
+            dynamicInput(&sbf);
             sbf.join();
         });
-        dyn_input_task.name("dynamic::input").succeed(collect_task);
+        dyn_input_task.name("dynamic::input");
+        for (auto &&task : dyn_publishers) {
+            dyn_input_task.succeed(task);
+        }
+        if (pipelinedFrame) {
+            dyn_input_task.succeed(dyn_output_task);
+        }
 
         auto dyn_tick_task = frame.emplace([this](tf::Subflow &sbf) {
-            for (auto &&[model_type, handle] : mm.dynamicModels) {
-                sbf.emplace(ModelTickFunc{*this, handle.obj, model_type});
-            }
+            dynamicTick(&sbf);
             sbf.join();
         });
         dyn_tick_task.name("dynamic::tick").succeed(dyn_input_task);
 
-        auto dyn_loop_condition = frame.emplace([this] { return s.loop != 0 ? 0 : 1; });
+        auto dyn_loop_condition = frame.emplace([this, &dyn_comp, pipelined = pipelinedFrame] {
+            if (!pipelined) {
+                return dyn_comp.loop != 0 ? 0 : 1;
+            }
+            dynClock.frame.fetch_add(1, std::memory_order_relaxed);
+            return --dynClock.loop != 0 ? 0 : 1;
+        });
         dyn_loop_condition.name("dynamic::next frame condition").precede(dyn_output_task).succeed(dyn_tick_task);
 
         // static tasks
-        tm.buffer.output_buffer.resize(mm.models.size());
-
-        for (auto &&[model_id, model_entity] : std::views::enumerate(mm.models)) {
-            auto &&[model_type, model_info] = model_entity;
-            auto it = tm.topics.find(model_type);
+        for (auto &&group : plan.groups) {
+            std::vector<ModelOutputFunc> outputs;
+            std::vector<ModelInputFunc> inputs;
+            std::vector<ModelTickFunc> ticks;
+            std::set<std::string> targets, reads;
+            bool direct_publisher = false;
+            for (auto model_id : group.models) {
+                auto &model_entity = mm.models[model_id];
+                auto &model_type = model_entity.modelTypeName;
+                auto &model_info = model_entity.handle;
+                auto &cost = costs[model_id];
+                auto it = tm.topics.find(model_type);
+                bool no_output = (it == tm.topics.end());
+                outputs.push_back(ModelOutputFunc{
+                    *this, model_info.obj, model_type, model_info.outputDataMovable, tm.buffer.output_buffer[model_id],
+                    no_output ? nullptr : &it->second, no_output, model_entity.publishIdentity,
+                    &tm.buffer.publish_state[model_id],
+                    pipelinedFrame ? &clocks[model_id].frame : &components[componentOfModel[model_id]].frame,
+                    &cost.output, &wakes[model_id]});
+                inputs.push_back(ModelInputFunc{*this, model_info.obj, model_type, model_entity.groupTypeName,
+                                                &cost.input, &wakes[model_id]});
+                ticks.push_back(ModelTickFunc{*this, model_info.obj, model_type, &cost.tick, &wakes[model_id]});
+                auto &tars = targetsOfType[model_type];
+                targets.insert(tars.begin(), tars.end());
+                reads.emplace(model_type);
+                if (!model_entity.groupTypeName.empty()) {
+                    reads.emplace(model_entity.groupTypeName);
+                }
+                direct_publisher = direct_publisher || tm.directTopics.contains(model_type) ||
+                                   tm.directTopics.contains(model_entity.groupTypeName);
+            }
+            auto &first = mm.models[group.models.front()];
+            auto name = group.models.size() == 1
+                            ? std::format("{}[{}]", first.modelTypeName, first.handle.obj->GetID())
+                            : std::format("{} models from {}[{}]", group.models.size(), first.modelTypeName,
+                                          first.handle.obj->GetID());
+            auto comp_id = componentOfModel[group.models.front()];
+            auto &comp = components[comp_id];
 
-            bool no_output = (it == tm.topics.end());
-            auto output_task = frame.emplace(
-                ModelOutputFunc{*this, model_info.obj, model_type, model_info.outputDataMovable,
-                                tm.buffer.output_buffer[model_id], no_output ? nullptr : &it->second, no_output});
-            output_task.name(std::format("{}[{}]::output", model_type, model_info.obj->GetID()));
+            auto output_task =
+                frame.emplace([&run = inlineOutputs.emplace_back(runAll(std::move(outputs)))] { run(); });
+            output_task.name(name + "::output").priority(group.priority);
 
             // find dependencies
-            for (auto &&target : targets[model_type]) {
-                tm.dependenciesOfTarget[target].emplace_back(model_id);
+            for (auto &&target : targets) {
                 if (auto it = collector.find(target); it != collector.end()) {
                     output_task.precede(it->second);
                 }
             }
 
             auto init_task = frame.emplace([] { return 0; });
-            init_task.name(std::format("{}[{}]::start loop", model_type, model_info.obj->GetID())).precede(output_task);
+            init_task.name(name + "::start loop").precede(output_task);
 
-            auto input_task = frame.emplace(ModelInputFunc{*this, model_info.obj, model_type});
-            input_task.name(std::format("{}[{}]::input", model_type, model_info.obj->GetID())).succeed(collect_task);
+            auto input_task = frame.emplace([&run = inlineInputs.emplace_back(runAll(std::move(inputs)))] { run(); });
+            input_task.name(name + "::input").priority(group.priority);
 
-            auto tick_task = frame.emplace(ModelTickFunc{*this, model_info.obj, model_type});
-            tick_task.name(std::format("{}[{}]::tick", model_type, model_info.obj->GetID())).succeed(input_task);
+            auto tick_task = frame.emplace([&run = inlineTicks.emplace_back(runAll(std::move(ticks)))] { run(); });
+            tick_task.name(name + "::tick").priority(group.priority).succeed(input_task);
 
-            auto loop_condition = frame.emplace([this] { return s.loop != 0 ? 0 : 1; });
-            loop_condition.name(std::format("{}[{}]::next frame condition", model_type, model_info.obj->GetID()))
-                .precede(output_task)
-                .succeed(tick_task);
+            if (!pipelinedFrame) {
+                // direct topics written in last tick or this output must be collected in this frame, and buffers read
+                // in last input must not be swapped before
+                output_task.precede(collect_tasks[comp_id]);
+                input_task.succeed(collect_tasks[comp_id]);
+                auto loop_condition = frame.emplace([&comp] { return comp.loop != 0 ? 0 : 1; });
+                loop_condition.name(name + "::next frame condition").precede(output_task).succeed(tick_task);
+                continue;
+            }
+
+            // buffers read in last input must not be swapped before this output
+            auto read_publishers = publishersOf(reads);
+            if (direct_publisher && direct_task &&
+                std::ranges::find(read_publishers, *direct_task) == read_publishers.end()) {
+                read_publishers.push_back(*direct_task);
+            }
+            for (auto &&task : read_publishers) {
+                output_task.precede(task);
+            }
+            // wait for topics of this frame to read, and for buffers written in this output to be published so they
+            // are not cleared by next output; direct topics written in next tick belong to next frame
+            input_task.succeed(output_task);
+            for (auto &&task : read_publishers) {
+                input_task.succeed(task);
+            }
+            for (auto &&task : publishersOf(targets)) {
+                if (std::ranges::find(read_publishers, task) == read_publishers.end()) {
+                    input_task.succeed(task);
+                }
+            }
+            std::vector<Clock *> group_clocks;
+            for (auto model_id : group.models) {
+                group_clocks.push_back(&clocks[model_id]);
+            }
+            auto loop_condition = frame.emplace([group_clocks] {
+                for (auto &&clock : group_clocks) {
+                    clock->frame.fetch_add(1, std::memory_order_relaxed);
+                }
+                return --group_clocks.front()->loop != 0 ? 0 : 1;
+            });
+            loop_condition.name(name + "::next frame condition").precede(output_task).succeed(tick_task);
         }
     }
 
     /**
-     * @brief call engine to run n times
+     * @brief call engine to run n times, replanned every replanPeriod frames if set
      *
-     * @param times times to run
+     * @param times times to run, frames skipped in event driven mode are counted
      */
     void run(size_t times = 1) {
         using namespace std::chrono;
-        if (times == 0) {
+        // no graph before a scene is loaded or after clear, e.g. by a failed load
+        if (times == 0 || components.empty()) {
             return;
         }
-        s.loop = times;
         auto p = high_resolution_clock::now();
-        executor.run(frame).wait();
+        if (eventDriven) {
+            runEvents(times);
+        } else {
+            eventStarted = false;
+            for (size_t left = times; left != 0;) {
+                auto n = replanPeriod == 0 ? left : std::min(left, replanPeriod);
+                runFrames(n);
+                // WakeAfter is ignored when frames are not skipped
+                mm.callback.takeWakeRequests();
+                left -= n;
+                if (replanPeriod != 0) {
+                    replan();
+                }
+            }
+            eventFrame += times;
+        }
         auto t = high_resolution_clock::now() - p;
         double t2 = double(duration_cast<microseconds>(t).count());
         s.fps = double(times) / (t2 * microseconds::period::num / microseconds::period::den);
     }
+
+    /**
+     * @brief run n frames without skipping any
+     *
+     */
+    void runFrames(size_t n) {
+        for (auto &&comp : components) {
+            comp.loop = n;
+        }
+        for (auto &&clock : clocks) {
+            clock.loop = n;
+        }
+        dynClock.loop = n;
+        if (inlineMode) {
+            runInline(n);
+        } else {
+            wait(executor->run(frame));
+        }
+    }
+
+    /**
+     * @brief run frames one by one, skipping frames in which no model is due and no topic is in flight
+     *
+     * @details a frame runs outputs of models ticked in last frame, inputs of all models, and ticks of models due in
+     * it or receiving topics; a tick spans all frames since the last tick of the model. WakeAfter delays are rounded
+     * up to whole frames, a model without request ticks again in next frame. Dynamic models run every frame, so
+     * frames are not skipped while any exists
+     */
+    void runEvents(size_t times) {
+        if (!eventStarted) {
+            for (auto &&w : wakes) {
+                w = {eventFrame, eventFrame, true, false, w.publishes};
+            }
+            mm.callback.takeWakeRequests();
+            eventStarted = true;
+        }
+        size_t end = eventFrame + times, executed = 0;
+        while (eventFrame < end) {
+            runFrames(1);
+            // earliest request of each model wins
+            std::unordered_map<size_t, size_t> requested;
+            for (auto &&r : mm.callback.takeWakeRequests()) {
+                auto it = modelOfCaller.find(std::pair{r.type, r.ID});
+                if (it == modelOfCaller.end()) {
+                    continue;
+                }
+                // delay of NaN or under one frame wakes model in next frame, huge delays are clamped to keep frames
+                // countable
+                double f = std::ceil(r.delay / s.dt);
+                size_t frames = !(f >= 1.) ? 1 : f >= 1e15 ? size_t(1e15) : size_t(f);
+                auto [req, inserted] = requested.try_emplace(it->second, frames);
+                req->second = std::min(req->second, frames);
+            }
+            for (auto &&[model_id, frames] : requested) {
+                auto &w = wakes[model_id];
+                // counted from the tick asking, which covered frames up to since - 1
+                w.due = w.since + frames - 1;
+            }
+            ++executed;
+            if (replanPeriod != 0 && executed % replanPeriod == 0) {
+                replan();
+            }
+            size_t next = end;
+            // topics sent in last tick are read in next frame
+            if (!mm.dynamicModels.empty() ||
+                std::ranges::any_of(wakes, [](const Wake &w) { return w.ticked && w.publishes; })) {
+                next = eventFrame + 1;
+            } else {
+                for (auto &&w : wakes) {
+                    next = std::min(next, std::max(w.due, eventFrame + 1));
+                }
+            }
+            eventFrame = std::min(next, end);
+        }
+    }
+
+    /**
+     * @brief run frames on calling thread, in an order the lockstep frame graph allows
+     *
+     */
+    void runInline(size_t times) {
+        for (size_t i = 0; i < times; ++i) {
+            dynamicOutput(nullptr, &components.front().frame);
+            for (auto &&output : inlineOutputs) {
+                output();
+            }
+            for (auto &&[idx, comp] : std::views::enumerate(components)) {
+                for (auto &&type : comp.targets) {
+                    tm.collectTarget(type, idx == 0);
+                }
+            }
+            tm.directTopicCollect(mm.callback.takeDirectTopicEvents());
+            // both kinds of frame counters are kept, so graph may be switched between modes
+            for (auto &&comp : components) {
+                for (auto &&type : comp.targets) {
+                    tm.buffer.swapTarget(type);
+                }
+                comp.frame.fetch_add(1, std::memory_order_relaxed);
+            }
+            for (auto &&clock : clocks) {
+                clock.frame.fetch_add(1, std::memory_order_relaxed);
+            }
+            dynClock.frame.fetch_add(1, std::memory_order_relaxed);
+            dynamicInput(nullptr);
+            for (auto &&input : inlineInputs) {
+                input();
+            }
+            dynamicTick(nullptr);
+            for (auto &&tick : inlineTicks) {
+                tick();
+            }
+        }
+    }
+
+    /**
+     * @brief wait for a run, busy waiting for spinMicros microseconds before sleeping
+     *
+     */
+    void wait(tf::Future<void> &&fu) {
+        using namespace std::chrono;
+        auto until = steady_clock::now() + microseconds(spinMicros);
+        while (spinMicros != 0 && fu.wait_for(seconds(0)) != std::future_status::ready && steady_clock::now() < until) {
+        }
+        fu.wait();
+    }
 };
@@ -0,0 +1,312 @@
+/**
+ * @file flatten.hpp
+ * @author glutamate
+ * @brief expand assembled model types into engine level sub models
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <expected>
+#include <format>
+#include <ranges>
+#include <set>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "assembleconfig.hpp"
+#include "engine/executionengine.hpp"
+
+/**
+ * @brief an assembled model type whose sub models are scheduled by the engine directly
+ *
+ * @details each sub model of an instance is an engine model of type "type[id]/sub", which receives sub model
+ * routing (output_convert) of that instance, and belongs to group "type/sub", which receives topics sent to the
+ * assembled type (through input_convert) and shared by all instances like before
+ */
+struct FlattenedType {
+    std::string typeName;
+    AssembleConfig config;
+    std::vector<uint64_t> instances = {};
+    // sub models publish topics of the assembled type
+    std::set<std::string> publishers = {};
+
+    std::string groupTypeName(const std::string &sub) const { return std::format("{}/{}", typeName, sub); }
+    std::string instanceTypeName(uint64_t ID, const std::string &sub) const {
+        return std::format("{}[{}]/{}", typeName, ID, sub);
+    }
+
+    /**
+     * @brief load assemble.yml and register sub model dlls as "type/sub"
+     *
+     * @param name assembled model type name
+     * @param location directory contains assemble.yml
+     */
+    static std::expected<FlattenedType, std::string> load(const std::string &name, const std::string &location,
+                                                          ModelManager &mm) {
+        auto ans = loadAssembleConfig(location);
+        if (!ans) {
+            return std::unexpected(std::move(ans.error()));
+        }
+        FlattenedType ret{name, std::move(*ans)};
+        if (!ret.config.restartKey.empty() || !ret.config.sideFilter.empty()) {
+            mm.callback.writeLog(
+                "Engine", std::format("restart_key and side_filter are ignored for flattened type {}", name), 3);
+        }
+        for (auto &&sub : ret.config.models) {
+            mm.registerDll(ret.groupTypeName(sub.name), sub.dll, sub.outputDataMovable);
+        }
+        return ret;
+    }
+
+    /**
+     * @brief create and init all sub models of an instance
+     *
+     * @param value init value of the assembled model, routed by init_convert
+     */
+    std::expected<void, std::string> createInstance(ModelManager &mm, uint64_t ID, uint16_t sideID,
+                                                    const CSValueMap &value) {
+        std::array<TransformInfo::InputBuffer, 1> buffers{
+            TransformInfo::InputBuffer{"root", const_cast<CSValueMap *>(&value), false}};
+        auto data = config.init.transform(std::span{buffers});
+        for (auto &&sub : config.models) {
+            auto ans = mm.createModel(ID, sideID, instanceTypeName(ID, sub.name), data[sub.name], false,
+                                      groupTypeName(sub.name));
+            if (!ans) {
+                return std::unexpected(
+                    std::format("Exception When Model[{}]Init: {}", instanceTypeName(ID, sub.name), ans.error()));
+            }
+        }
+        instances.push_back(ID);
+        return {};
+    }
+
+    /**
+     * @brief route input of assembled type to sub model groups
+     *
+     * @param action action to assembled type, options other than target and name are kept
+     * @return actions to sub model groups, empty if assembled model will drop it
+     */
+    std::vector<TransformInfo::Action> retarget(const TransformInfo::Action &action) const {
+        std::vector<TransformInfo::Action> ret;
+        auto root = config.input.rules.find("root");
+        if (root == config.input.rules.end()) {
+            return ret;
+        }
+        if (auto it = root->second.find(action.dstName); it != root->second.end()) {
+            for (auto &&act : it->second) {
+                auto &r = ret.emplace_back(action);
+                r.to = groupTypeName(act.to);
+                r.dstName = act.dstName;
+            }
+        }
+        return ret;
+    }
+
+    /**
+     * @brief rewrite a topic published by the assembled type into per instance topics published by one sub model
+     *
+     * @param topic topic whose targets are already retargeted
+     * @param out topic table to append to
+     */
+    std::expected<void, std::string> publish(const TopicManager::TopicInfo &topic, TopicManager::ModelTopics &out) {
+        static const std::set<std::string, std::less<>> identity{"ForceSideID", "ModelID", "InstanceName", "ID",
+                                                                 "State"};
+        // root output name -> (sub, name in sub output)
+        std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>> rootSources;
+        for (auto &&[from, srcs] : config.output.rules) {
+            for (auto &&[src, acts] : srcs) {
+                for (auto &&act : acts) {
+                    if (act.to == "root") {
+                        rootSources[act.dstName].emplace_back(from, src);
+                    }
+                }
+            }
+        }
+        auto provide = [&](const std::string &sub, const std::string &name) -> const std::string * {
+            auto it = rootSources.find(name);
+            if (it == rootSources.end()) {
+                return nullptr;
+            }
+            auto it2 = std::ranges::find(it->second, sub, &std::pair<std::string, std::string>::first);
+            return it2 == it->second.end() ? nullptr : &it2->second;
+        };
+
+        auto rules = topic.trans.rules.find(typeName);
+        std::vector<std::string> names = topic.members;
+        if (rules != topic.trans.rules.end()) {
+            for (auto &&[src, _] : rules->second) {
+                names.push_back(src);
+            }
+        }
+        // the sub model provides every non-identity name, prefer the one provides most identity names
+        const AssembleConfig::SubModel *publisher = nullptr;
+        size_t providedIdentity = 0;
+        for (auto &&sub : config.models) {
+            bool ok = std::ranges::all_of(
+                names, [&](auto &name) { return identity.contains(name) || provide(sub.name, name); });
+            auto cnt = std::ranges::count_if(identity, [&](auto &name) { return provide(sub.name, name) != nullptr; });
+            if (ok && (!publisher || size_t(cnt) > providedIdentity)) {
+                publisher = &sub;
+                providedIdentity = cnt;
+            }
+        }
+        if (!publisher) {
+            return std::unexpected(std::format("can not flatten topic from {}: members are output by different sub "
+                                               "models, or not routed to root in output_convert",
+                                               typeName));
+        }
+        publishers.emplace(publisher->name);
+
+        auto rename = [&](const std::string &name) -> const std::string & {
+            auto p = provide(publisher->name, name);
+            return p ? *p : name;
+        };
+        for (auto ID : instances) {
+            auto from = instanceTypeName(ID, publisher->name);
+            TopicManager::TopicInfo t = topic;
+            t.members.clear();
+            for (auto &&m : topic.members) {
+                t.members.push_back(rename(m));
+            }
+            t.always.clear();
+            for (auto &&m : topic.always) {
+                t.always.push_back(rename(m));
+            }
+            t.key = rename(topic.key);
+            t.trans.rules.clear();
+            if (rules != topic.trans.rules.end()) {
+                for (auto &&[src, acts] : rules->second) {
+                    auto &tar = t.trans.rules[from][rename(src)];
+                    tar.insert(tar.end(), acts.begin(), acts.end());
+                }
+            }
+            out[from].push_back(std::move(t));
+        }
+        return {};
+    }
+
+    /**
+     * @brief retarget actions to flattened types in place, drop actions the assembled model would drop
+     *
+     */
+    static void retargetRules(TransformInfo &trans, const std::unordered_map<std::string, FlattenedType> &flattened) {
+        for (auto &&srcs : trans.rules | std::views::values) {
+            for (auto &&acts : srcs | std::views::values) {
+                std::vector<TransformInfo::Action> newActs;
+                for (auto &&act : acts) {
+                    if (auto it = flattened.find(act.to); it != flattened.end()) {
+                        newActs.append_range(it->second.retarget(act));
+                    } else {
+                        newActs.push_back(act);
+                    }
+                }
+                acts = std::move(newActs);
+            }
+            std::erase_if(srcs, [](auto &p) { return p.second.empty(); });
+        }
+    }
+
+    /**
+     * @brief add per instance topics for sub model to sub model routing in output_convert
+     *
+     */
+    void addInternalTopics(TopicManager::ModelTopics &out) const {
+        for (auto ID : instances) {
+            for (auto &&[from, srcs] : config.output.rules) {
+                TopicManager::TopicInfo t{};
+                auto instanceFrom = instanceTypeName(ID, from);
+                for (auto &&[src, acts] : srcs) {
+                    for (auto &&act : acts) {
+                        if (act.to != "root") {
+                            t.trans.rules[instanceFrom][src].push_back({instanceTypeName(ID, act.to), act.dstName});
+                        }
+                    }
+                }
+                if (!t.trans.rules.empty()) {
+                    out[instanceFrom].push_back(std::move(t));
+                }
+            }
+        }
+    }
+};
+
+/**
+ * @brief rewrite direct topic table, topics written by any sub model of a flattened type are published as if the
+ * assembled model wrote them
+ *
+ * @param topics direct topics parsed from scene file
+ * @param flattened flattened types
+ */
+inline void flattenDirectTopics(TopicManager::DirectTopics &topics,
+                                const std::unordered_map<std::string, FlattenedType> &flattened) {
+    TopicManager::DirectTopics ret;
+    for (auto &&[from, list] : topics) {
+        auto publisher = flattened.find(from);
+        for (auto &&[name, topic] : list) {
+            TopicManager::TopicInfo t = topic;
+            FlattenedType::retargetRules(t.trans, flattened);
+            if (publisher == flattened.end()) {
+                ret[from].insert_or_assign(name, std::move(t));
+                continue;
+            }
+            // direct topics written by sub models are published as their group type
+            for (auto &&sub : publisher->second.config.models) {
+                auto group = publisher->second.groupTypeName(sub.name);
+                TopicManager::TopicInfo subTopic = t;
+                subTopic.trans.rules.clear();
+                if (auto it = t.trans.rules.find(from); it != t.trans.rules.end()) {
+                    subTopic.trans.rules.emplace(group, it->second);
+                }
+                ret[group].insert_or_assign(name, std::move(subTopic));
+            }
+        }
+    }
+    topics = std::move(ret);
+}
+
+/**
+ * @brief rewrite topic table after all instances of flattened types are created
+ *
+ * @param topics topic table parsed from scene file
+ * @param flattened flattened types
+ */
+inline std::expected<void, std::string> flattenTopics(TopicManager::ModelTopics &topics, ModelManager &mm,
+                                                      std::unordered_map<std::string, FlattenedType> &flattened) {
+    TopicManager::ModelTopics ret;
+    for (auto &&[from, list] : topics) {
+        auto publisher = flattened.find(from);
+        for (auto &&topic : list) {
+            TopicManager::TopicInfo t = topic;
+            FlattenedType::retargetRules(t.trans, flattened);
+            if (publisher == flattened.end()) {
+                ret[from].push_back(std::move(t));
+            } else if (auto ans = publisher->second.publish(t, ret); !ans) {
+                return ans;
+            }
+        }
+    }
+    for (auto &&[_, type] : flattened) {
+        type.addInternalTopics(ret);
+    }
+    topics = std::move(ret);
+
+    for (auto &&m : mm.models) {
+        for (auto &&[_, type] : flattened) {
+            for (auto &&sub : type.publishers) {
+                if (m.groupTypeName == type.groupTypeName(sub)) {
+                    m.publishIdentity = true;
+                }
+            }
+        }
+    }
+    return {};
+}
@@ -0,0 +1,226 @@
+/**
+ * @file logger.hpp
+ * @author glutamate
+ * @brief asynchronous logger, producers push into per-thread rings and a background thread writes file
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "perthread.hpp"
+
+/**
+ * @brief lock-free on the logging thread unless its ring is full, file io happens on writer
+ *
+ * @details text format: "[src-level]: msg\n", same as former synchronous log.
+ * binary format: "SCQLOG1\n" followed by records of
+ * (int64 ns since epoch, int32 level, uint32 src size, src, uint32 msg size, msg), all little endian native.
+ *
+ */
+class AsyncLogger {
+  public:
+    AsyncLogger() : writer([this](std::stop_token token) { run(token); }) {}
+    AsyncLogger(const AsyncLogger &) = delete;
+    AsyncLogger &operator=(const AsyncLogger &) = delete;
+    ~AsyncLogger() {
+        writer.request_stop();
+        writer.join();
+        drain();
+    }
+
+    /**
+     * @brief test if a message of given level will be written, all writeLog variants check this first
+     */
+    bool enabled(int32_t level) const noexcept {
+        return hasFile.load(std::memory_order_relaxed) && enable.load(std::memory_order_relaxed) &&
+               level >= minLevel.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief log a formatted message, copied only when level passes
+     */
+    void writeLog(std::string_view src, std::string_view msg, int32_t level) noexcept {
+        if (!enabled(level)) {
+            return;
+        }
+        push({now(), level, std::string(src), std::string(msg)});
+    }
+
+    /**
+     * @brief log a message built by makeMsg, which is called on the current thread only when level passes
+     *
+     * @param makeMsg callable returns something convertible to std::string
+     */
+    template <std::invocable Fn> void writeLog(std::string_view src, int32_t level, Fn &&makeMsg) noexcept {
+        if (!enabled(level)) {
+            return;
+        }
+        try {
+            push({now(), level, std::string(src), std::string(std::invoke(std::forward<Fn>(makeMsg)))});
+        } catch (...) {
+        }
+    }
+
+    /**
+     * @brief write to given file, close current file if any
+     *
+     * @param path empty to disable file output
+     */
+    void open(const std::string &path) {
+        std::lock_guard<std::mutex> lck{fileLock};
+        drainLocked();
+        file = {};
+        filePath = path;
+        hasFile.store(false, std::memory_order_relaxed);
+        if (path.empty()) {
+            return;
+        }
+        bool bin = binary.load(std::memory_order_relaxed);
+        file.open(path, bin ? std::ios::out | std::ios::binary : std::ios::out);
+        if (bin && file) {
+            file << "SCQLOG1\n";
+        }
+        hasFile.store(bool(file), std::memory_order_relaxed);
+    }
+    /**
+     * @brief switch output format, reopen current file if any
+     */
+    void setBinary(bool on) {
+        std::string path;
+        {
+            std::lock_guard<std::mutex> lck{fileLock};
+            if (binary.load(std::memory_order_relaxed) == on) {
+                return;
+            }
+            binary.store(on, std::memory_order_relaxed);
+            path = filePath;
+        }
+        if (!path.empty()) {
+            open(path);
+        }
+    }
+    bool isBinary() const { return binary.load(std::memory_order_relaxed); }
+    void setLevel(int32_t level) { minLevel.store(level, std::memory_order_relaxed); }
+    int32_t level() const { return minLevel.load(std::memory_order_relaxed); }
+    void setEnable(bool on) { enable.store(on, std::memory_order_relaxed); }
+    bool isEnabled() const { return enable.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief write all messages pushed before this call
+     */
+    void flush() { drain(); }
+
+  private:
+    struct Record {
+        // ns since system clock epoch
+        int64_t time;
+        int32_t level;
+        std::string src, msg;
+    };
+
+    // single producer (owner thread) single consumer (holder of fileLock)
+    struct Ring {
+        static constexpr size_t capacity = 1024;
+        std::vector<Record> slots = std::vector<Record>(capacity);
+        alignas(64) std::atomic<size_t> head = 0;
+        alignas(64) std::atomic<size_t> tail = 0;
+    };
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void push(Record &&rec) {
+        auto &ring = rings.local();
+        auto h = ring.head.load(std::memory_order_relaxed);
+        // full: wait for writer rather than drop, errors should not get lost
+        while (h - ring.tail.load(std::memory_order_acquire) == Ring::capacity) {
+            std::this_thread::yield();
+        }
+        ring.slots[h % Ring::capacity] = std::move(rec);
+        ring.head.store(h + 1, std::memory_order_release);
+    }
+
+    void run(std::stop_token token) {
+        using namespace std::chrono_literals;
+        while (!token.stop_requested()) {
+            if (drain() == 0) {
+                std::this_thread::sleep_for(1ms);
+            }
+        }
+    }
+
+    size_t drain() {
+        std::lock_guard<std::mutex> lck{fileLock};
+        return drainLocked();
+    }
+
+    size_t drainLocked() {
+        batch.clear();
+        rings.forEach([this](Ring &ring) {
+            auto t = ring.tail.load(std::memory_order_relaxed);
+            auto h = ring.head.load(std::memory_order_acquire);
+            for (; t != h; ++t) {
+                batch.push_back(std::move(ring.slots[t % Ring::capacity]));
+            }
+            ring.tail.store(t, std::memory_order_release);
+        });
+        if (batch.empty()) {
+            return 0;
+        }
+        // keep global order across threads within a batch
+        std::ranges::stable_sort(batch, {}, &Record::time);
+        for (auto &&rec : batch) {
+            if (!file) {
+                continue;
+            }
+            if (binary.load(std::memory_order_relaxed)) {
+                auto put = [this](const auto &v) { file.write(reinterpret_cast<const char *>(&v), sizeof(v)); };
+                put(rec.time);
+                put(rec.level);
+                put(uint32_t(rec.src.size()));
+                file.write(rec.src.data(), rec.src.size());
+                put(uint32_t(rec.msg.size()));
+                file.write(rec.msg.data(), rec.msg.size());
+            } else {
+                file << std::format("[{}-{}]: {}\n", rec.src, rec.level, rec.msg);
+            }
+        }
+        file.flush();
+        return batch.size();
+    }
+
+    std::atomic<int32_t> minLevel = 0;
+    std::atomic<bool> enable = true, hasFile = false;
+    tools::PerThread<Ring> rings;
+
+    // guards file and consumer side of rings
+    std::mutex fileLock;
+    std::ofstream file;
+    std::string filePath;
+    // written under fileLock, read without it by isBinary
+    std::atomic<bool> binary = false;
+    std::vector<Record> batch;
+
+    // last member, started after everything above is ready
+    std::jthread writer;
+};
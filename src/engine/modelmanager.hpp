@@ -25,6 +25,11 @@ using CSValueMap = std::unordered_map<std::string, std::any>;
 struct ModelEntity {
     std::string modelTypeName;
     ModelObjHandle handle;
+    // type name whose topics are also delivered to this model, used by flattened assembled models to share
+    // topics sent to the assembled type among all instances while keeping sub model routing per instance
+    std::string groupTypeName = {};
+    // add ID, ForceSideID, ModelID, InstanceName and State to output like an assembled model does
+    bool publishIdentity = false;
 };
 
 struct ModelManager {
@@ -35,39 +40,62 @@ struct ModelManager {
      * @param sideID model side id
      * @param type model type
      * @param dynamic is dynamically created, should not be false when create in running, or will change model vector
+     * @param group see prepareModel
      */
     std::expected<ModelEntity*, std::string> createModel(uint64_t ID, uint16_t sideID, const std::string& type,
-                                                          const CSValueMap &value, bool dynamic) {
-        return loader.loadModel(type).and_then(
-            [&, this](ModelEntity entity) -> std::expected<ModelEntity*, std::string> {
-                std::vector<ModelEntity> &tar = dynamic ? dynamicModels : models;
-                auto &model = tar.emplace_back(std::move(entity));
-                model.handle.obj->SetID(ID);
-                model.handle.obj->SetForceSideID(sideID);
-                model.handle.obj->SetLogFun([this, type](const std::string &msg, uint32_t level) {
-                    callback.writeLog(type, msg, level);
-                });
-                model.handle.obj->SetCommonCallBack(
-                    [this](const std::string &type, const std::unordered_map<std::string, std::any> &param) {
-                        callback.commonCallBack(type, param);
-                        return std::string{};
-                    });
-                auto ans = doWithCatch([&] {
-                    if (!model.handle.obj->Init(value)) {
-                        throw std::logic_error("init function return false");
-                    }
+                                                          const CSValueMap &value, bool dynamic,
+                                                          const std::string &group = {}) {
+        return prepareModel(ID, sideID, type, value, group).transform([&, this](ModelEntity entity) {
+            return addModel(std::move(entity), dynamic);
+        });
+    }
+    /**
+     * @brief create and initialize a model entity without adding it to model vectors
+     *
+     * @param group if not empty, dll registered as group is loaded and the model is named type in group, see
+     * ModelEntity::groupTypeName
+     * @attention thread-safe as long as no dll is being registered and model Init is thread-safe
+     */
+    std::expected<ModelEntity, std::string> prepareModel(uint64_t ID, uint16_t sideID, const std::string &type,
+                                                         const CSValueMap &value, const std::string &group = {}) {
+        const std::string &dll = group.empty() ? type : group;
+        return loader.loadModel(dll).and_then([&, this](ModelEntity model) -> std::expected<ModelEntity, std::string> {
+            model.modelTypeName = type;
+            model.groupTypeName = group;
+            model.handle.obj->SetID(ID);
+            model.handle.obj->SetForceSideID(sideID);
+            model.handle.obj->SetLogFun(
+                [this, type](const std::string &msg, uint32_t level) { callback.writeLog(type, msg, level); });
+            model.handle.obj->SetCommonCallBack(
+                [this, caller = CallbackHandler::Caller{ID, type, group}](
+                    const std::string &type, const std::unordered_map<std::string, std::any> &param) mutable {
+                    return callback.commonCallBack(caller, type, param);
                 });
-                if (!ans) {
-                    tar.pop_back();
-                    return std::unexpected(ans.error());
+            auto ans = doWithCatch([&] {
+                if (!model.handle.obj->Init(value)) {
+                    throw std::logic_error("init function return false");
                 }
-                modelTypes.emplace(type);
-                return &model;
             });
+            if (!ans) {
+                return std::unexpected(ans.error());
+            }
+            return model;
+        });
+    }
+    /**
+     * @brief append a model entity created by prepareModel
+     *
+     * @param dynamic is dynamically created, should not be false when create in running, or will change model vector
+     */
+    ModelEntity *addModel(ModelEntity entity, bool dynamic) {
+        std::vector<ModelEntity> &tar = dynamic ? dynamicModels : models;
+        modelTypes.emplace(entity.modelTypeName);
+        return &tar.emplace_back(std::move(entity));
     }
     std::expected<void, std::string> loadDll(const std::string &name, const std::string &path, bool move) {
         return loader.loadDll(name, path, move);
     }
+    void registerDll(const std::string &name, ModelDllInterface dll, bool move) { loader.addDll(name, dll, move); }
     void destoryKilledModel() {
         // update expire time
         for (auto&& m : dynamicModels) {
@@ -86,14 +114,17 @@ struct ModelManager {
         });
         dynamicModels.erase(it, dynamicModels.end());
     }
+    /**
+     * @brief create models requested since last call, in order of (creator ID, request order of that creator)
+     *
+     */
     void createDynamicModel() {
-        for (auto &&[ID, sideID, param, type] : callback.createModelCommands) {
+        for (auto &&[creator, seq, creatorType, ID, sideID, param, type] : callback.takeCreateModelCommands()) {
             createModel(ID, sideID, type, param, true).transform_error([this](auto&& err) -> int {
                 callback.writeLog("Engine", std::format("Exception When Create Dynamic Model: {}", err), 5);
                 return 0;
             });
         }
-        callback.createModelCommands.clear();
     }
 
     // TODO: std::unordered_map<std::string, ModelObjHandle>
@@ -112,7 +143,9 @@ struct ModelManager {
                 return std::unexpected("no such type");
             }
             auto model = ::loadModel(it->second);
-            model.outputDataMovable = movable[type];
+            // no insertion here, may be called concurrently
+            auto it2 = movable.find(type);
+            model.outputDataMovable = it2 != movable.end() && it2->second;
             return ModelEntity{type, std::move(model)};
         }
         std::expected<void, std::string> loadDll(const std::string &name, const std::string &path, bool move) {
@@ -120,10 +153,13 @@ struct ModelManager {
             if (!ans) {
                 return std::unexpected(std::string(ans.error()));
             }
-            dlls[name] = ans.value();
-            movable[name] = move;
+            addDll(name, ans.value(), move);
             return std::expected<void, std::string>{};
         }
+        void addDll(const std::string &name, ModelDllInterface dll, bool move) {
+            dlls[name] = dll;
+            movable[name] = move;
+        }
 
       private:
         std::unordered_map<std::string, ModelDllInterface> dlls;
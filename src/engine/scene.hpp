@@ -0,0 +1,737 @@
+/**
+ * @file scene.hpp
+ * @author glutamate
+ * @brief scene description parsed from yaml, and its precompiled binary cache
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <any>
+#include <cstdint>
+#include <cstring>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "yaml-cpp/yaml.h"
+
+#include "anyprocess.hpp"
+#include "mappedfile.hpp"
+#include "parseany.hpp"
+
+using CSValueMap = std::unordered_map<std::string, std::any>;
+
+/**
+ * @brief everything of a scene file the engine needs, with init values already parsed
+ *
+ */
+struct SceneDesc {
+    struct ModelType {
+        std::string name, path;
+        bool movable = false;
+        bool flatten = false;
+        // only for flattened types, empty for directory of path
+        std::string assembleDir = {};
+        // may be created by CreateEntity, kept with dynamic models when models are partitioned
+        bool dynamic = false;
+    };
+    struct Model {
+        std::string type;
+        uint64_t id;
+        uint16_t sideID;
+        // parsed init_value, without ID and ForceSideID
+        CSValueMap value;
+    };
+    struct Convert {
+        std::string to, src, dst;
+        bool snapshot = false;
+        uint32_t period = 1;
+    };
+    struct Topic {
+        std::string from;
+        std::vector<std::string> members;
+        bool direct = false;
+        std::string name = {};
+        std::vector<Convert> converts = {};
+        bool delta = false;
+        std::vector<std::string> always = {};
+        bool latest = false;
+        std::string key = {};
+        uint32_t period = 1;
+        // subscriber -> member -> (op -> operand), see TopicFilter::compile
+        std::unordered_map<std::string, CSValueMap> where = {};
+    };
+
+    struct Template {
+        std::string type;
+        // parsed init_value
+        CSValueMap value;
+    };
+    /**
+     * @brief one replicate directive: `count` models from a template, with ID = idStart + i * idStep and
+     * field = start + i * step for every field
+     *
+     */
+    struct Replicate {
+        struct Field {
+            std::string name;
+            double start, step;
+        };
+        // index in templates
+        size_t tmpl;
+        uint64_t count;
+        uint64_t idStart, idStep;
+        uint16_t sideID;
+        std::vector<Field> fields;
+    };
+
+    std::vector<ModelType> modelTypes;
+    // models listed in scene, followed by replicated instances once expanded
+    std::vector<Model> models;
+    // kept unexpanded until expand, so the binary cache stores each template once
+    std::vector<Template> templates;
+    std::vector<Replicate> replicates;
+    std::vector<Topic> topics;
+
+    // call fn(i) for every i in [0, n), maybe concurrently
+    using ForEachIndex = std::function<void(size_t, const std::function<void(size_t)> &)>;
+
+    /**
+     * @brief parse scene yaml, init values are parsed through forEach; replicate directives are not expanded
+     *
+     */
+    static std::expected<SceneDesc, std::string> fromYAML(const YAML::Node &config, const ForEachIndex &forEach) {
+        SceneDesc ret;
+        for (auto &&n : config["model_types"]) {
+            ret.modelTypes.push_back({n["model_type_name"].as<std::string>(), n["dll_path"].as<std::string>(),
+                                      n["output_movable"].as<bool>(false), n["flatten"].as<bool>(false),
+                                      n["assemble_dir"].as<std::string>(""), n["dynamic"].as<bool>(false)});
+        }
+        std::vector<std::string> initValues;
+        for (auto &&n : config["models"]) {
+            ret.models.push_back({n["model_type"].as<std::string>(), n["id"].as<uint64_t>(),
+                                  n["side_id"].as<uint16_t>(), {}});
+            initValues.push_back(n["init_value"].as<std::string>());
+        }
+        // templates are parsed along with models, each only once
+        std::unordered_map<std::string, size_t> templateIndex;
+        for (auto &&n : config["templates"]) {
+            auto name = n["name"].as<std::string>();
+            if (!templateIndex.emplace(name, ret.templates.size()).second) {
+                return std::unexpected(std::format("duplicated template {}", name));
+            }
+            ret.templates.push_back({n["model_type"].as<std::string>(), {}});
+            initValues.push_back(n["init_value"].as<std::string>());
+        }
+        std::vector<CSValueMap> values(initValues.size());
+        std::vector<std::string> errors(initValues.size());
+        forEach(initValues.size(), [&](size_t i) {
+            auto ans = tools::myany::parseXMLStringView(initValues[i]);
+            if (!ans) {
+                errors[i] = std::format("error when parse \"{}\" : {}", initValues[i], ans.error());
+            } else if (ans.value().type() != typeid(CSValueMap)) {
+                errors[i] = std::format("error when parse \"{}\" : must be CSValueMap", initValues[i]);
+            } else {
+                values[i] = std::any_cast<CSValueMap>(std::move(ans.value()));
+            }
+        });
+        for (auto &&err : errors) {
+            if (!err.empty()) {
+                return std::unexpected(std::move(err));
+            }
+        }
+        for (auto &&[m, value] : std::views::zip(ret.models, values)) {
+            m.value = std::move(value);
+        }
+        for (auto &&[t, value] : std::views::zip(ret.templates, std::span{values}.subspan(ret.models.size()))) {
+            t.value = std::move(value);
+        }
+        if (auto ans = ret.parseReplicate(config["replicate"], templateIndex); !ans) {
+            return std::unexpected(ans.error());
+        }
+        for (auto &&n : config["topics"]) {
+            Topic t{n["from"].as<std::string>(), n["members"].as<std::vector<std::string>>(std::vector<std::string>{}),
+                    n["direct"].as<bool>(false), n["name"].as<std::string>("")};
+            t.delta = n["delta"].as<bool>(false);
+            t.always = n["always"].as<std::vector<std::string>>(std::vector<std::string>{});
+            t.period = n["period"].as<uint32_t>(1);
+            if (t.period == 0) {
+                return std::unexpected(std::format("topic from {} has period 0", t.from));
+            }
+            if (auto mode = n["mode"].as<std::string>("queue"); mode == "latest") {
+                t.latest = true;
+                t.key = n["key"].as<std::string>("");
+                if (t.key.empty()) {
+                    return std::unexpected(std::format("latest topic from {} has no key", t.from));
+                }
+            } else if (mode != "queue") {
+                return std::unexpected(std::format("unknown mode {} of topic from {}", mode, t.from));
+            }
+            for (auto &&sub : n["subscribers"]) {
+                auto to = sub["to"].as<std::string>();
+                auto snapshot = sub["snapshot"].as<bool>(false);
+                auto period = sub["period"].as<uint32_t>(1);
+                if (period == 0) {
+                    return std::unexpected(std::format("subscriber {} of topic from {} has period 0", to, t.from));
+                }
+                if (auto where = sub["where"]) {
+                    auto &conditions = t.where[to];
+                    for (auto &&member : where) {
+                        CSValueMap ops;
+                        for (auto &&op : member.second) {
+                            // numbers are kept as double, anything else as string
+                            double x;
+                            if (YAML::convert<double>::decode(op.second, x)) {
+                                ops.emplace(op.first.as<std::string>(), x);
+                            } else {
+                                ops.emplace(op.first.as<std::string>(), op.second.as<std::string>());
+                            }
+                        }
+                        conditions.emplace(member.first.as<std::string>(), std::move(ops));
+                    }
+                }
+                for (auto &&convert : sub["name_convert"]) {
+                    auto src = convert["name"].as<std::string>(convert["src_name"].as<std::string>(""));
+                    auto dst = convert["name"].as<std::string>(convert["dst_name"].as<std::string>(""));
+                    t.converts.push_back({to, std::move(src), std::move(dst), snapshot, period});
+                }
+            }
+            if (!t.direct && !n["members"]) {
+                return std::unexpected(std::format("topic from {} has no members", t.from));
+            }
+            if (t.direct && t.name.empty()) {
+                return std::unexpected(std::format("direct topic from {} has no name", t.from));
+            }
+            if (t.direct && t.delta) {
+                return std::unexpected(std::format("direct topic {} from {} can not be delta", t.name, t.from));
+            }
+            ret.topics.push_back(std::move(t));
+        }
+        return ret;
+    }
+
+    /**
+     * @brief read replicate directives, start of a field defaults to its value in template
+     *
+     */
+    std::expected<void, std::string> parseReplicate(const YAML::Node &directives,
+                                                    const std::unordered_map<std::string, size_t> &templateIndex) {
+        for (auto &&n : directives) {
+            auto name = n["template"].as<std::string>();
+            auto it = templateIndex.find(name);
+            if (it == templateIndex.end()) {
+                return std::unexpected(std::format("unknown template {} in replicate", name));
+            }
+            Replicate d{it->second, n["count"].as<uint64_t>(), 0, 1, n["side_id"].as<uint16_t>(), {}};
+            if (auto id = n["id"]; id.IsMap()) {
+                d.idStart = id["start"].as<uint64_t>();
+                d.idStep = id["step"].as<uint64_t>(1);
+            } else {
+                d.idStart = id.as<uint64_t>();
+            }
+            auto &tmpl = templates[d.tmpl].value;
+            for (auto &&f : n["fields"]) {
+                auto field = f.first.as<std::string>();
+                double start = 0.;
+                if (f.second["start"]) {
+                    start = f.second["start"].as<double>();
+                } else if (auto it = tmpl.find(field); it != tmpl.end()) {
+                    auto v = toDouble(it->second);
+                    if (!v) {
+                        return std::unexpected(std::format("field {} of template {} is not numeric", field, name));
+                    }
+                    start = *v;
+                } else {
+                    return std::unexpected(std::format("field {} not in template {} and has no start", field, name));
+                }
+                d.fields.push_back({std::move(field), start, f.second["step"].as<double>(0.)});
+            }
+            replicates.push_back(std::move(d));
+        }
+        return {};
+    }
+
+    /**
+     * @brief expand replicate directives, instances are appended to models in directive order; templates and
+     * directives are consumed
+     *
+     * @details a field keeps the numeric type of its value in template, double if template has no such field
+     */
+    std::expected<void, std::string> expand(const ForEachIndex &forEach) {
+        size_t total = models.size();
+        std::vector<std::pair<const Replicate *, size_t>> jobs;
+        for (auto &&d : replicates) {
+            total += d.count;
+        }
+        jobs.reserve(total - models.size());
+        for (auto &&d : replicates) {
+            for (size_t i = 0; i < d.count; ++i) {
+                jobs.emplace_back(&d, i);
+            }
+        }
+        auto offset = models.size();
+        models.resize(total);
+        std::vector<std::string> errors(jobs.size());
+        forEach(jobs.size(), [&](size_t j) {
+            auto &[d, i] = jobs[j];
+            auto &m = models[offset + j];
+            m.type = templates[d->tmpl].type;
+            m.id = d->idStart + i * d->idStep;
+            m.sideID = d->sideID;
+            m.value = templates[d->tmpl].value;
+            for (auto &&[name, start, step] : d->fields) {
+                auto &v = m.value[name];
+                double x = start + double(i) * step;
+                if (!v.has_value()) {
+                    v = x;
+                } else if (!fromDouble(v, x)) {
+                    errors[j] = std::format("field {} of model {} is not numeric", name, m.id);
+                }
+            }
+        });
+        templates.clear();
+        replicates.clear();
+        for (auto &&err : errors) {
+            if (!err.empty()) {
+                return std::unexpected(std::move(err));
+            }
+        }
+        return {};
+    }
+
+    /**
+     * @brief load scene file, reuse "<file>.cqc" if it is compiled from same content, otherwise parse yaml and
+     * rewrite it; replicate directives are expanded after either
+     *
+     * @param useCache read and write binary cache
+     */
+    static std::expected<SceneDesc, std::string> load(const std::string &file, bool useCache,
+                                                      const ForEachIndex &forEach) {
+        std::string content;
+        if (auto ifs = std::ifstream(file, std::ios::binary); ifs) {
+            content.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        } else {
+            return std::unexpected(std::format("can not open scene file {}", file));
+        }
+        auto hash = fnv1a(content);
+        auto cacheFile = file + ".cqc";
+        if (useCache) {
+            if (auto mapped = MappedFile::open(cacheFile)) {
+                if (auto ans = fromBinary(mapped->data(), hash)) {
+                    if (auto expanded = ans->expand(forEach); !expanded) {
+                        return std::unexpected(expanded.error());
+                    }
+                    return ans;
+                }
+            }
+        }
+        YAML::Node config;
+        try {
+            config = YAML::Load(content);
+        } catch (YAML::Exception &err) {
+            return std::unexpected(std::format("error when parsing {}: {}", file, err.what()));
+        }
+        auto ret = fromYAML(config, forEach);
+        if (ret && useCache) {
+            // best effort, write aside then replace so readers never map a half written file; a stale or broken
+            // cache is rejected by hash and size checks anyway
+            auto tmpFile = cacheFile + ".tmp";
+            if (auto ofs = std::ofstream(tmpFile, std::ios::binary); ofs) {
+                ofs << ret->toBinary(hash);
+            }
+            std::error_code ec;
+            std::filesystem::rename(tmpFile, cacheFile, ec);
+        }
+        if (ret) {
+            if (auto expanded = ret->expand(forEach); !expanded) {
+                return std::unexpected(expanded.error());
+            }
+        }
+        return ret;
+    }
+
+    /**
+     * @brief encode scene before expand, strings (names, map keys and string values) are interned into a table
+     *
+     * @param hash hash of the source yaml
+     */
+    std::string toBinary(uint64_t hash) const {
+        Writer w;
+        for (auto &&t : modelTypes) {
+            w.str(t.name);
+            w.str(t.path);
+            w.u8(uint8_t(t.movable) | uint8_t(t.flatten) << 1 | uint8_t(t.dynamic) << 2);
+            w.str(t.assembleDir);
+        }
+        for (auto &&m : models) {
+            w.str(m.type);
+            w.u64(m.id);
+            w.u16(m.sideID);
+            w.map(m.value);
+        }
+        for (auto &&t : templates) {
+            w.str(t.type);
+            w.map(t.value);
+        }
+        for (auto &&d : replicates) {
+            w.u64(d.tmpl);
+            w.u64(d.count);
+            w.u64(d.idStart);
+            w.u64(d.idStep);
+            w.u16(d.sideID);
+            w.u32(uint32_t(d.fields.size()));
+            for (auto &&[name, start, step] : d.fields) {
+                w.str(name);
+                w.raw(start);
+                w.raw(step);
+            }
+        }
+        for (auto &&t : topics) {
+            w.str(t.from);
+            w.u8(uint8_t(t.direct) | uint8_t(t.delta) << 1 | uint8_t(t.latest) << 2);
+            w.str(t.name);
+            w.str(t.key);
+            w.u32(t.period);
+            w.u32(uint32_t(t.members.size()));
+            for (auto &&m : t.members) {
+                w.str(m);
+            }
+            w.u32(uint32_t(t.converts.size()));
+            for (auto &&[to, src, dst, snapshot, period] : t.converts) {
+                w.str(to);
+                w.str(src);
+                w.str(dst);
+                w.u8(snapshot);
+                w.u32(period);
+            }
+            w.u32(uint32_t(t.always.size()));
+            for (auto &&m : t.always) {
+                w.str(m);
+            }
+            w.u32(uint32_t(t.where.size()));
+            for (auto &&[to, where] : t.where) {
+                w.str(to);
+                w.map(where);
+            }
+        }
+
+        Writer head;
+        head.out.append(magic);
+        head.u64(hash);
+        head.u32(uint32_t(w.strings.size()));
+        for (auto &&s : w.strings) {
+            head.u32(uint32_t(s.size()));
+            head.out.append(s);
+        }
+        head.u32(uint32_t(modelTypes.size()));
+        head.u32(uint32_t(models.size()));
+        head.u32(uint32_t(templates.size()));
+        head.u32(uint32_t(replicates.size()));
+        head.u32(uint32_t(topics.size()));
+        return head.out + w.out;
+    }
+
+    /**
+     * @brief decode scene written by toBinary
+     *
+     * @param hash expected hash of the source yaml
+     */
+    static std::expected<SceneDesc, std::string> fromBinary(std::string_view data, uint64_t hash) {
+        try {
+            Reader r{data};
+            if (r.bytes(magic.size()) != magic) {
+                return std::unexpected("bad magic");
+            }
+            if (r.u64() != hash) {
+                return std::unexpected("outdated");
+            }
+            r.strings.resize(r.u32());
+            for (auto &&s : r.strings) {
+                s = r.bytes(r.u32());
+            }
+            SceneDesc ret;
+            ret.modelTypes.resize(r.u32());
+            ret.models.resize(r.u32());
+            ret.templates.resize(r.u32());
+            ret.replicates.resize(r.u32());
+            ret.topics.resize(r.u32());
+            for (auto &&t : ret.modelTypes) {
+                t.name = r.str();
+                t.path = r.str();
+                auto flags = r.u8();
+                t.movable = flags & 1;
+                t.flatten = flags & 2;
+                t.dynamic = flags & 4;
+                t.assembleDir = r.str();
+            }
+            for (auto &&m : ret.models) {
+                m.type = r.str();
+                m.id = r.u64();
+                m.sideID = r.u16();
+                m.value = r.map();
+            }
+            for (auto &&t : ret.templates) {
+                t.type = r.str();
+                t.value = r.map();
+            }
+            for (auto &&d : ret.replicates) {
+                d.tmpl = r.u64();
+                if (d.tmpl >= ret.templates.size()) {
+                    return std::unexpected("bad template index");
+                }
+                d.count = r.u64();
+                d.idStart = r.u64();
+                d.idStep = r.u64();
+                d.sideID = r.u16();
+                d.fields.resize(r.u32());
+                for (auto &&[name, start, step] : d.fields) {
+                    name = r.str();
+                    start = r.raw<double>();
+                    step = r.raw<double>();
+                }
+            }
+            for (auto &&t : ret.topics) {
+                t.from = r.str();
+                auto flags = r.u8();
+                t.direct = flags & 1;
+                t.delta = flags & 2;
+                t.latest = flags & 4;
+                t.name = r.str();
+                t.key = r.str();
+                t.period = r.u32();
+                t.members.resize(r.u32());
+                for (auto &&m : t.members) {
+                    m = r.str();
+                }
+                t.converts.resize(r.u32());
+                for (auto &&[to, src, dst, snapshot, period] : t.converts) {
+                    to = r.str();
+                    src = r.str();
+                    dst = r.str();
+                    snapshot = r.u8();
+                    period = r.u32();
+                }
+                t.always.resize(r.u32());
+                for (auto &&m : t.always) {
+                    m = r.str();
+                }
+                for (auto n = r.u32(); n != 0; --n) {
+                    auto to = r.str();
+                    t.where.insert_or_assign(std::move(to), r.map());
+                }
+            }
+            if (!r.in.empty()) {
+                return std::unexpected("trailing data");
+            }
+            return ret;
+        } catch (std::exception &err) {
+            return std::unexpected(err.what());
+        }
+    }
+
+  private:
+    static constexpr std::string_view magic{"SCQSCN07"};
+
+    static std::optional<double> toDouble(const std::any &v) {
+        return tools::myany::visit<tools::myany::err>(
+            []<typename Ty>(const Ty &value) -> std::optional<double> {
+                if constexpr (std::is_arithmetic_v<Ty> && !std::is_same_v<Ty, bool>) {
+                    return double(value);
+                } else {
+                    return std::nullopt;
+                }
+            },
+            v);
+    }
+    // assign x to v, keeping its held numeric type
+    static bool fromDouble(std::any &v, double x) {
+        return tools::myany::visit<tools::myany::err>(
+            [x]<typename Ty>(Ty &value) -> bool {
+                if constexpr (std::is_arithmetic_v<Ty> && !std::is_same_v<Ty, bool>) {
+                    value = Ty(x);
+                    return true;
+                } else {
+                    return false;
+                }
+            },
+            v);
+    }
+
+    // type tag of std::any values
+    enum struct Tag : uint8_t { f64, f32, map, list, str, i64, u64, i32, u32, i16, u16, i8, u8, boolean };
+
+    static uint64_t fnv1a(std::string_view data) {
+        uint64_t h = 14695981039346656037ull;
+        for (unsigned char c : data) {
+            h = (h ^ c) * 1099511628211ull;
+        }
+        return h;
+    }
+
+    struct Writer {
+        std::string out;
+        std::vector<std::string_view> strings;
+        std::unordered_map<std::string_view, uint32_t> index;
+
+        template <typename Ty> void raw(Ty v) {
+            char buf[sizeof(Ty)];
+            std::memcpy(buf, &v, sizeof(Ty));
+            out.append(buf, sizeof(Ty));
+        }
+        void u8(uint8_t v) { raw(v); }
+        void u16(uint16_t v) { raw(v); }
+        void u32(uint32_t v) { raw(v); }
+        void u64(uint64_t v) { raw(v); }
+        // strings are owned by the scene being written
+        void str(std::string_view s) {
+            auto [it, inserted] = index.try_emplace(s, uint32_t(strings.size()));
+            if (inserted) {
+                strings.push_back(s);
+            }
+            u32(it->second);
+        }
+        void map(const CSValueMap &m) {
+            u32(uint32_t(m.size()));
+            for (auto &&[k, v] : m) {
+                str(k);
+                any(v);
+            }
+        }
+        void any(const std::any &v) {
+            tools::myany::visit<tools::myany::err>(
+                [this]<typename Ty>(const Ty &value) {
+                    using T = std::remove_cvref_t<Ty>;
+                    if constexpr (std::is_same_v<T, CSValueMap>) {
+                        u8(uint8_t(Tag::map));
+                        map(value);
+                    } else if constexpr (std::is_same_v<T, std::vector<std::any>>) {
+                        u8(uint8_t(Tag::list));
+                        u32(uint32_t(value.size()));
+                        for (auto &&e : value) {
+                            any(e);
+                        }
+                    } else if constexpr (std::is_same_v<T, std::string>) {
+                        u8(uint8_t(Tag::str));
+                        str(value);
+                    } else {
+                        u8(uint8_t(tagOf<T>()));
+                        raw(value);
+                    }
+                },
+                v);
+        }
+    };
+
+    struct Reader {
+        std::string_view in;
+        std::vector<std::string_view> strings = {};
+
+        std::string_view bytes(size_t n) {
+            if (in.size() < n) {
+                throw std::out_of_range("truncated");
+            }
+            auto ret = in.substr(0, n);
+            in.remove_prefix(n);
+            return ret;
+        }
+        template <typename Ty> Ty raw() {
+            Ty v;
+            std::memcpy(&v, bytes(sizeof(Ty)).data(), sizeof(Ty));
+            return v;
+        }
+        uint8_t u8() { return raw<uint8_t>(); }
+        uint16_t u16() { return raw<uint16_t>(); }
+        uint32_t u32() { return raw<uint32_t>(); }
+        uint64_t u64() { return raw<uint64_t>(); }
+        std::string str() { return std::string(strings.at(u32())); }
+        CSValueMap map() {
+            CSValueMap ret;
+            auto n = u32();
+            ret.reserve(n);
+            for (uint32_t i = 0; i < n; ++i) {
+                auto k = str();
+                ret.emplace(std::move(k), any());
+            }
+            return ret;
+        }
+        std::any any() {
+            switch (Tag(u8())) {
+            case Tag::f64:
+                return raw<double>();
+            case Tag::f32:
+                return raw<float>();
+            case Tag::map:
+                return map();
+            case Tag::list: {
+                std::vector<std::any> ret(u32());
+                for (auto &&e : ret) {
+                    e = any();
+                }
+                return ret;
+            }
+            case Tag::str:
+                return str();
+            case Tag::i64:
+                return raw<int64_t>();
+            case Tag::u64:
+                return raw<uint64_t>();
+            case Tag::i32:
+                return raw<int32_t>();
+            case Tag::u32:
+                return raw<uint32_t>();
+            case Tag::i16:
+                return raw<int16_t>();
+            case Tag::u16:
+                return raw<uint16_t>();
+            case Tag::i8:
+                return raw<int8_t>();
+            case Tag::u8:
+                return raw<uint8_t>();
+            case Tag::boolean:
+                return raw<bool>();
+            }
+            throw std::out_of_range("unknown type tag");
+        }
+    };
+
+    template <typename Ty> static constexpr Tag tagOf() {
+        if constexpr (std::is_same_v<Ty, double>) {
+            return Tag::f64;
+        } else if constexpr (std::is_same_v<Ty, float>) {
+            return Tag::f32;
+        } else if constexpr (std::is_same_v<Ty, int64_t>) {
+            return Tag::i64;
+        } else if constexpr (std::is_same_v<Ty, uint64_t>) {
+            return Tag::u64;
+        } else if constexpr (std::is_same_v<Ty, int32_t>) {
+            return Tag::i32;
+        } else if constexpr (std::is_same_v<Ty, uint32_t>) {
+            return Tag::u32;
+        } else if constexpr (std::is_same_v<Ty, int16_t>) {
+            return Tag::i16;
+        } else if constexpr (std::is_same_v<Ty, uint16_t>) {
+            return Tag::u16;
+        } else if constexpr (std::is_same_v<Ty, int8_t>) {
+            return Tag::i8;
+        } else if constexpr (std::is_same_v<Ty, uint8_t>) {
+            return Tag::u8;
+        } else {
+            static_assert(std::is_same_v<Ty, bool>);
+            return Tag::boolean;
+        }
+    }
+};
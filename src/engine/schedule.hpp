@@ -0,0 +1,170 @@
+/**
+ * @file schedule.hpp
+ * @author glutamate
+ * @brief measured cost of model phases, and plans ordering and grouping model tasks by them
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <expected>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "yaml-cpp/yaml.h"
+
+#include "taskflow/taskflow.hpp"
+
+/**
+ * @brief moving averages of time spent in each phase of a model, in microseconds
+ *
+ */
+struct ModelCost {
+    // weight of newest sample
+    static constexpr double alpha = 0.1;
+    double output = 0., input = 0., tick = 0.;
+
+    double total() const { return output + input + tick; }
+
+    static void update(double &avg, std::chrono::steady_clock::duration d) {
+        double us = std::chrono::duration<double, std::micro>(d).count();
+        avg = avg == 0. ? us : avg + (us - avg) * alpha;
+    }
+};
+
+/**
+ * @brief measure one phase of a model until destructed, does nothing if target is null
+ *
+ */
+struct CostTimer {
+    double *target;
+    std::chrono::steady_clock::time_point start;
+    explicit CostTimer(double *target)
+        : target(target), start(target ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{}) {}
+    CostTimer(const CostTimer &) = delete;
+    ~CostTimer() {
+        if (target) {
+            ModelCost::update(*target, std::chrono::steady_clock::now() - start);
+        }
+    }
+};
+
+/**
+ * @brief which static models share a task and how urgent each task is
+ *
+ * @details tasks are created per group in each phase; a group runs its models one by one in model order
+ */
+struct SchedulePlan {
+    struct Group {
+        std::vector<size_t> models;
+        tf::TaskPriority priority = tf::TaskPriority::NORMAL;
+        bool operator==(const Group &) const = default;
+    };
+    std::vector<Group> groups;
+    bool operator==(const SchedulePlan &) const = default;
+
+    /**
+     * @brief models of a component whose cost is under grain are batched until a batch reaches grain, then tasks
+     * are ranked by cost: the most expensive third starts first and the cheapest third last
+     *
+     * @param costs cost of every static model
+     * @param component component of every static model, models are only batched within a component
+     * @param grain batch size in microseconds, 0 for one task per model
+     */
+    static SchedulePlan make(const std::vector<ModelCost> &costs, const std::vector<size_t> &component,
+                             double grain) {
+        SchedulePlan ret;
+        // component -> group of its unfilled batch
+        std::map<size_t, size_t> open;
+        std::vector<double> groupCost;
+        for (size_t i = 0; i < costs.size(); ++i) {
+            double cost = costs[i].total();
+            if (grain <= 0. || cost >= grain) {
+                ret.groups.push_back({{i}});
+                groupCost.push_back(cost);
+                continue;
+            }
+            auto it = open.find(component[i]);
+            if (it == open.end()) {
+                it = open.emplace(component[i], ret.groups.size()).first;
+                ret.groups.emplace_back();
+                groupCost.push_back(0.);
+            }
+            auto group = it->second;
+            ret.groups[group].models.push_back(i);
+            groupCost[group] += cost;
+            if (groupCost[group] >= grain) {
+                open.erase(it);
+            }
+        }
+
+        // nothing measured yet, keep default priority
+        if (std::ranges::all_of(groupCost, [](double c) { return c == 0.; })) {
+            return ret;
+        }
+        std::vector<size_t> rank(ret.groups.size());
+        std::iota(rank.begin(), rank.end(), size_t(0));
+        std::ranges::stable_sort(rank, std::greater<>{}, [&](size_t g) { return groupCost[g]; });
+        for (size_t i = 0; i < rank.size(); ++i) {
+            ret.groups[rank[i]].priority = i * 3 < rank.size()       ? tf::TaskPriority::HIGH
+                                           : i * 3 < rank.size() * 2 ? tf::TaskPriority::NORMAL
+                                                                     : tf::TaskPriority::LOW;
+        }
+        return ret;
+    }
+};
+
+/**
+ * @brief costs keyed by (model type, ID), saved next to scene file to plan a loaded scene without warming up
+ *
+ */
+using CostTable = std::map<std::pair<std::string, uint64_t>, ModelCost>;
+
+inline std::expected<void, std::string> saveCostTable(const CostTable &table, const std::string &file) {
+    std::ofstream f(file);
+    if (!f) {
+        return std::unexpected(std::format("can not open {}", file));
+    }
+    // emitted rather than formatted, so any type name is quoted and escaped as loadCostTable expects
+    YAML::Emitter out;
+    out << YAML::Comment("moving averages of model phases, us") << YAML::BeginSeq;
+    for (auto &&[key, cost] : table) {
+        out << YAML::Flow << YAML::BeginMap;
+        out << YAML::Key << "type" << YAML::Value << YAML::DoubleQuoted << key.first;
+        out << YAML::Key << "id" << YAML::Value << key.second;
+        out << YAML::Key << "output" << YAML::Value << cost.output;
+        out << YAML::Key << "input" << YAML::Value << cost.input;
+        out << YAML::Key << "tick" << YAML::Value << cost.tick;
+        out << YAML::EndMap;
+    }
+    out << YAML::EndSeq;
+    if (!out.good()) {
+        return std::unexpected(std::format("can not write cost table: {}", out.GetLastError()));
+    }
+    f << out.c_str() << '\n';
+    return {};
+}
+
+inline std::expected<CostTable, std::string> loadCostTable(const std::string &file) {
+    try {
+        CostTable ret;
+        for (auto &&n : YAML::LoadFile(file)) {
+            ret.insert_or_assign({n["type"].as<std::string>(), n["id"].as<uint64_t>()},
+                                 ModelCost{n["output"].as<double>(), n["input"].as<double>(), n["tick"].as<double>()});
+        }
+        return ret;
+    } catch (const std::exception &e) {
+        return std::unexpected(std::format("bad cost table {}: {}", file, e.what()));
+    }
+}
@@ -0,0 +1,160 @@
+/**
+ * @file topicfilter.hpp
+ * @author glutamate
+ * @brief subscriber side `where` predicates of topics, compiled once when scene is loaded
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <any>
+#include <expected>
+#include <format>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "anyprocess.hpp"
+#include "csmodel_base.h"
+
+/**
+ * @brief conjunction of conditions on members of a topic, all named by publisher output names
+ *
+ * @details conditions comparing with a constant are tested against publisher output before a message is built.
+ * conditions comparing with `self` compare with receiver ForceSideID or ID, so publisher values are carried along
+ * with message and tested right before SetInput of every receiver.
+ * messages missing a tested member, or whose member has an incomparable type, fail.
+ */
+struct TopicFilter {
+    struct Condition {
+        std::string member;
+        std::function<bool(const std::any &)> test;
+    };
+    struct SelfCondition {
+        std::string member;
+        bool sideID;
+        std::function<bool(double, double)> cmp;
+    };
+    std::vector<Condition> conditions;
+    std::vector<SelfCondition> selfConditions;
+
+    bool test(const std::unordered_map<std::string, std::any> &output) const {
+        for (auto &&c : conditions) {
+            auto it = output.find(c.member);
+            if (it == output.end() || !c.test(it->second)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief take publisher values of self conditions
+     *
+     * @return false if any of them is missing or not numeric
+     */
+    bool collectSelf(const std::unordered_map<std::string, std::any> &output, std::vector<double> &values) const {
+        values.clear();
+        for (auto &&c : selfConditions) {
+            auto it = output.find(c.member);
+            auto v = it == output.end() ? std::nullopt : toDouble(it->second);
+            if (!v) {
+                return false;
+            }
+            values.push_back(*v);
+        }
+        return true;
+    }
+
+    bool testSelf(const std::vector<double> &values, CSModelObject &receiver) const {
+        for (size_t i = 0; i < selfConditions.size(); ++i) {
+            auto &c = selfConditions[i];
+            double self = c.sideID ? double(receiver.GetForceSideID()) : double(receiver.GetID());
+            if (!c.cmp(values[i], self)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief compile `where` of a subscriber
+     *
+     * @param where member -> (op -> operand); op is one of eq, ne, lt, le, gt, ge; operand is a number, a string
+     * (eq and ne only) or "self" (member ForceSideID or ID only)
+     */
+    static std::expected<TopicFilter, std::string> compile(const std::unordered_map<std::string, std::any> &where) {
+        TopicFilter ret;
+        for (auto &&[member, opsAny] : where) {
+            auto ops = std::any_cast<std::unordered_map<std::string, std::any>>(&opsAny);
+            if (!ops) {
+                return std::unexpected(std::format("conditions on {} should be a map of op to operand", member));
+            }
+            for (auto &&[op, operand] : *ops) {
+                auto cmp = comparator(op);
+                if (!cmp) {
+                    return std::unexpected(std::format("unknown op {} on {}", op, member));
+                }
+                auto str = std::any_cast<std::string>(&operand);
+                if (str && *str == "self") {
+                    if (member != "ForceSideID" && member != "ID") {
+                        return std::unexpected(std::format("self can only be compared with ForceSideID or ID, not {}",
+                                                           member));
+                    }
+                    ret.selfConditions.push_back({member, member == "ForceSideID", std::move(cmp)});
+                } else if (auto x = toDouble(operand)) {
+                    ret.conditions.push_back({member, [x = *x, cmp = std::move(cmp)](const std::any &v) {
+                                                  auto y = toDouble(v);
+                                                  return y && cmp(*y, x);
+                                              }});
+                } else if (str && (op == "eq" || op == "ne")) {
+                    ret.conditions.push_back({member, [s = *str, eq = op == "eq"](const std::any &v) {
+                                                  auto p = std::any_cast<std::string>(&v);
+                                                  return p && (*p == s) == eq;
+                                              }});
+                } else {
+                    return std::unexpected(std::format("bad operand of {} on {}", op, member));
+                }
+            }
+        }
+        return ret;
+    }
+
+  private:
+    static std::function<bool(double, double)> comparator(const std::string &op) {
+        if (op == "eq") {
+            return std::equal_to<double>{};
+        } else if (op == "ne") {
+            return std::not_equal_to<double>{};
+        } else if (op == "lt") {
+            return std::less<double>{};
+        } else if (op == "le") {
+            return std::less_equal<double>{};
+        } else if (op == "gt") {
+            return std::greater<double>{};
+        } else if (op == "ge") {
+            return std::greater_equal<double>{};
+        }
+        return {};
+    }
+
+    static std::optional<double> toDouble(const std::any &v) {
+        struct Other {
+            std::optional<double> operator()(const std::any &) const { return std::nullopt; }
+        };
+        return tools::myany::visit<Other>(
+            []<typename Ty>(const Ty &value) -> std::optional<double> {
+                if constexpr (std::is_arithmetic_v<Ty> && !std::is_same_v<Ty, bool>) {
+                    return double(value);
+                } else {
+                    return std::nullopt;
+                }
+            },
+            v);
+    }
+};
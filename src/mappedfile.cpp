@@ -0,0 +1,102 @@
+#include "mappedfile.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile &&o) noexcept
+    : ptr(std::exchange(o.ptr, nullptr)), size(std::exchange(o.size, 0)), file(std::exchange(o.file, nullptr)),
+      mapping(std::exchange(o.mapping, nullptr)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&o) noexcept {
+    if (this != &o) {
+        close();
+        ptr = std::exchange(o.ptr, nullptr);
+        size = std::exchange(o.size, 0);
+        file = std::exchange(o.file, nullptr);
+        mapping = std::exchange(o.mapping, nullptr);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() { close(); }
+
+std::expected<MappedFile, std::string> MappedFile::open(const std::string &path) {
+    MappedFile ret;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return std::unexpected("open file error");
+    }
+    ret.file = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        return std::unexpected("get file size error");
+    }
+    ret.size = size_t(size.QuadPart);
+    if (ret.size == 0) {
+        return ret;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        return std::unexpected("map file error");
+    }
+    ret.mapping = mapping;
+    ret.ptr = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!ret.ptr) {
+        return std::unexpected("map file error");
+    }
+#else  // _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return std::unexpected("open file error");
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return std::unexpected("get file size error");
+    }
+    ret.size = size_t(st.st_size);
+    if (ret.size != 0) {
+        void *p = mmap(nullptr, ret.size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            ret.size = 0;
+            return std::unexpected("map file error");
+        }
+        ret.ptr = static_cast<const char *>(p);
+    }
+    // mapping stays valid after close
+    ::close(fd);
+#endif // _WIN32
+    return ret;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (ptr) {
+        UnmapViewOfFile(ptr);
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+    }
+    if (file) {
+        CloseHandle(file);
+    }
+#else  // _WIN32
+    if (ptr) {
+        munmap(const_cast<char *>(ptr), size);
+    }
+#endif // _WIN32
+    ptr = nullptr;
+    size = 0;
+    file = mapping = nullptr;
+}
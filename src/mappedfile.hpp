@@ -0,0 +1,39 @@
+/**
+ * @file mappedfile.hpp
+ * @author glutamate
+ * @brief read-only memory mapped file
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <expected>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief whole file mapped read-only, unmapped on destruction
+ *
+ */
+struct MappedFile {
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile(MappedFile &&o) noexcept;
+    MappedFile &operator=(MappedFile &&o) noexcept;
+    ~MappedFile();
+
+    static std::expected<MappedFile, std::string> open(const std::string &path);
+
+    std::string_view data() const { return {ptr, size}; }
+
+  private:
+    void close();
+
+    const char *ptr = nullptr;
+    size_t size = 0;
+    // platform handles, unused on posix
+    void *file = nullptr, *mapping = nullptr;
+};
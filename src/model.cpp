@@ -8,6 +8,8 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <ranges>
+#include <set>
 #include <span>
 #include <string>
 #include <unordered_map>
@@ -15,6 +17,9 @@
 
 #include <assert.h>
 
+#include <taskflow/taskflow.hpp>
+
+#include "assembleconfig.hpp"
 #include "csmodel_base.h"
 #include "datatransform.hpp"
 #include "dllop.hpp"
@@ -33,98 +38,76 @@ class MyAssembledModel : public CSModelObject {
     // init: root->subs
     // input: root->subs
     // output: subs->subs, subs->root
-    MyAssembledModel() = default;
+    MyAssembledModel()
+        : rootZone{profiler.registerZone("root: init"), profiler.registerZone("root: before_input"),
+                   profiler.registerZone("root: before_output"), profiler.registerZone("root: after_output")} {}
     virtual bool Init(const std::unordered_map<std::string, std::any> &value) override {
-        auto p = profiler.startRecord("root: init");
-
         if (!log_) {
             log_ = [](auto msg, auto) { std::cout << std::format("[AssembleModel]: ", msg) << std::endl; };
         }
 
-        auto location = getLibDir();
-        auto configFile = location + "assemble.yml";
-        auto config = YAML::LoadFile(configFile);
-        for (auto &&model : config["models"]) {
-            auto name = model["model_name"].as<std::string>();
-            auto dllName = model["dll_name"].as<std::string>();
-            if (dllName.starts_with("./") || (!dllName.contains('/') && !dllName.contains('\\'))) {
-                dllName = location + dllName;
-            }
-            auto modelObj = loadModel(dllName);
-            if (!modelObj.has_value()) {
-                auto errorInfo = std::format("[AssembledModel] error when loading [{}]: ", name);
-                errorInfo += modelObj.error();
-                WriteLog(errorInfo, 4);
+        if (!config) {
+            auto ans = loadAssembleConfigCached(getLibDir());
+            if (!ans) {
+                WriteLog(ans.error(), 4);
                 return false;
             }
-            auto [it, _] = subModels.emplace(name, std::move(*modelObj));
-            if (model["output_movable"]) {
-                it->second.outputDataMovable = model["output_movable"].as<bool>();
+            config = std::move(*ans);
+            if (!config->profileFile.empty()) {
+                profiler.enable();
             }
+            if (!config->traceFile.empty()) {
+                profiler.enableTrace();
+            }
+            outputRules = config->output;
         }
-        if (&value != &initValue) {
+
+        auto p = profiler.startRecord(rootZone.init);
+
+        for (auto &&sub : config->models) {
+            auto [it, _] = subModels.emplace(
+                sub.name, SubModel{loadModel(sub.dll),
+                                   {profiler.registerZone(sub.name + ": init"), profiler.registerZone(sub.name + ": tick"),
+                                    profiler.registerZone(sub.name + ": input"),
+                                    profiler.registerZone(sub.name + ": output")}});
+            it->second.handle.outputDataMovable = sub.outputDataMovable;
+        }
+        if (&value != &initValue && !config->restartKey.empty()) {
             // first init
-            if (config["config"]) {
-                auto n = config["config"];
-                if (n["profile"]) {
-                    profileFile = n["profile"].as<std::string>();
-                }
-                if (n["restart_key"]) {
-                    restartKey = n["restart_key"].as<std::string>();
-                    // if(&value != &initValue)
-                    initValue = value;
-                }
-                if (n["side_filter"]) {
-                    sideFilter = n["side_filter"].as<std::string>();
-                }
-                if (n["log_level"]) {
-                    logLevel = n["log_level"].as<uint32_t>();
-                }
-            }
-            auto load = [&config](TransformInfo &tar, const std::string &name, auto check) {
-                for (auto &&rule : config[name.data()]) {
-                    std::string from = rule["from"] ? rule["from"].as<std::string>() : "root";
-                    std::string to = rule["to"] ? rule["to"].as<std::string>() : "root";
-                    check(from, to);
-                    for (auto &&value : rule["values"]) {
-                        std::string srcName =
-                            value["name"] ? value["name"].as<std::string>() : value["src_name"].as<std::string>();
-                        std::string dstName =
-                            value["name"] ? value["name"].as<std::string>() : value["dst_name"].as<std::string>();
-                        tar.rules[from][srcName].push_back(TransformInfo::Action{
-                            .to = to,
-                            .dstName = dstName,
-                        });
-                    }
-                }
-            };
-            load(init, "init_convert", [](auto &from, auto &to) { assert(from == "root"); });
-            load(input, "input_convert", [](auto &from, auto &to) { assert(from == "root"); });
-            load(output, "output_convert", [](auto &from, auto &to) { assert(from != "root"); });
+            initValue = value;
         }
-        
+
         SetState(CSInstanceState::IS_INITIALIZED);
 
         std::array<TransformInfo::InputBuffer, 1> buffers{
             TransformInfo::InputBuffer{"root", const_cast<CSValueMap *>(&value), false}};
-        auto data = init.transform(std::span{buffers});
+        auto data = config->init.transform(std::span{buffers});
 
         p.end();
 
-        for (auto &&[modelName, modelInfo] : subModels) {
-            auto p = profiler.startRecord(modelName + ": init");
+        for (auto &&[modelName, sub] : subModels) {
+            auto p = profiler.startRecord(sub.zone.init);
+            auto &modelInfo = sub.handle;
             modelInfo.obj->SetLogFun([this, modelName](auto msg, auto level) {
-                if (level >= logLevel) {
+                if (level >= config->logLevel) {
                     WriteLog(std::format("SubModel[{}]Log: {}", modelName, msg), level);
                 }
             });
-            modelInfo.obj->SetCommonCallBack(com_cb_);
+            modelInfo.obj->SetCommonCallBack([this, modelName](const std::string &fun, const CSValueMap &params) {
+                if (fun == "GetConsumedFields") {
+                    auto it = subConsumed.find(modelName);
+                    return it == subConsumed.end() ? ""s : it->second;
+                }
+                return com_cb_(fun, params);
+            });
             modelInfo.obj->SetID(GetID());
             modelInfo.obj->SetForceSideID(GetForceSideID());
 
             modelInfo.obj->Init(data[modelName]);
         }
 
+        buildSubModelFlow();
+
         return true;
     };
 
@@ -133,35 +116,39 @@ class MyAssembledModel : public CSModelObject {
             return true;
         }
 
-        for (auto &&[modelName, modelInfo] : subModels) {
-            auto p = profiler.startRecord(modelName + ": tick");
-            modelInfo.obj->Tick(time);
+        tickTime = time;
+        if (!config->parallel || !corun(tickFlow)) {
+            for (auto &&[sub, slot] : ordered) {
+                auto p = profiler.startRecord(sub->zone.tick);
+                sub->handle.obj->Tick(time);
+            }
         }
 
         return true;
     };
 
     virtual bool SetInput(const std::unordered_map<std::string, std::any> &value) override {
-        if (restartFlag || (restartKey.size() && value.contains(restartKey))) {
+        if (restartFlag || (config->restartKey.size() && value.contains(config->restartKey))) {
             restartFlag = true;
             return true;
         }
-        if (!sideFilter.empty()) {
-            if (auto it = value.find(sideFilter);
+        if (!config->sideFilter.empty()) {
+            if (auto it = value.find(config->sideFilter);
                 it != value.end() && GetForceSideID() != std::any_cast<uint16_t>(it->second)) {
                 return true;
             }
         }
 
-        auto p1 = profiler.startRecord("root: before_input");
+        auto p1 = profiler.startRecord(rootZone.beforeInput);
         std::array<TransformInfo::InputBuffer, 1> buffers{
             TransformInfo::InputBuffer{"root", const_cast<CSValueMap *>(&value), false}};
-        auto data = input.transform(std::span{buffers});
+        auto data = config->input.transform(std::span{buffers});
 
         p1.end();
         for (auto &&[modelName, inputData] : data) {
-            auto p2 = profiler.startRecord(modelName + ": input");
-            subModels.find(modelName)->second.obj->SetInput(inputData);
+            auto &sub = subModels.find(modelName)->second;
+            auto p2 = profiler.startRecord(sub.zone.input);
+            sub.handle.obj->SetInput(inputData);
         }
 
         return true;
@@ -172,30 +159,31 @@ class MyAssembledModel : public CSModelObject {
             restart();
         }
 
-        auto p1 = profiler.startRecord("root: before_output");
+        auto p1 = profiler.startRecord(rootZone.beforeOutput);
         // set ID
         if (!realInited) {
-            for (auto &[name, modelInfo] : subModels) {
-                modelInfo.obj->SetID(GetID());
-                modelInfo.obj->SetForceSideID(GetForceSideID());
+            for (auto &[name, sub] : subModels) {
+                sub.handle.obj->SetID(GetID());
+                sub.handle.obj->SetForceSideID(GetForceSideID());
             }
             SetState(CSInstanceState::IS_RUNNING);
             realInited = true;
+            // topics are known to engine by now
+            resolveConsumedFields();
         }
 
-        std::vector<TransformInfo::InputBuffer> buffers;
-        buffers.reserve(subModels.size());
-
         p1.end();
 
-        for (auto &&[modelName, modelInfo] : subModels) {
-            auto p2 = profiler.startRecord(modelName + ": output");
-            buffers.emplace_back(modelName, modelInfo.obj->GetOutput(), modelInfo.outputDataMovable);
+        if (!config->parallel || !corun(outputFlow)) {
+            for (auto &&[sub, slot] : ordered) {
+                auto p2 = profiler.startRecord(sub->zone.output);
+                slot->buffer = sub->handle.obj->GetOutput();
+            }
         }
 
-        auto p3 = profiler.startRecord("root: after_output");
+        auto p3 = profiler.startRecord(rootZone.afterOutput);
 
-        auto data = output.transform(std::span{buffers});
+        auto data = outputRules.transform(std::span{outputSlots});
 
         if (auto it = data.find("root"); it != data.end()) {
             outputBuffer = std::move(it->second);
@@ -215,28 +203,125 @@ class MyAssembledModel : public CSModelObject {
         p3.end();
 
         for (auto &&[modelName, inputData] : data) {
-            auto p2 = profiler.startRecord(modelName + ": input");
-            subModels.find(modelName)->second.obj->SetInput(inputData);
+            auto &sub = subModels.find(modelName)->second;
+            auto p2 = profiler.startRecord(sub.zone.input);
+            sub.handle.obj->SetInput(inputData);
         }
 
         return &outputBuffer;
     };
     ~MyAssembledModel() {
-        if (!profileFile.empty()) {
-            std::ofstream ofs(profileFile);
+        if (config && !config->profileFile.empty()) {
+            std::ofstream ofs(config->profileFile);
             ofs << profiler.getResult() << std::endl;
         }
+        if (config && !config->traceFile.empty()) {
+            std::ofstream ofs(config->traceFile);
+            ofs << profiler.getChromeTrace() << std::endl;
+        }
     }
 
   private:
     bool realInited = false;
+    /**
+     * @brief drop output rules to root whose result no topic reads, and derive fields each sub model must output
+     *
+     * @details engine replies fields of this type read by any topic; empty reply means unknown, keep everything
+     */
+    void resolveConsumedFields() {
+        if (!com_cb_) {
+            return;
+        }
+        auto reply = CommonCallBack("GetConsumedFields", {});
+        if (reply.empty()) {
+            return;
+        }
+        // State is read here to update instance state
+        std::set<std::string, std::less<>> consumed{"State"};
+        for (auto &&name : std::views::split(reply, ',')) {
+            consumed.emplace(std::string_view(name));
+        }
+        for (auto &&[from, srcs] : outputRules.rules) {
+            for (auto &&acts : srcs | std::views::values) {
+                std::erase_if(acts, [&](auto &act) { return act.to == "root" && !consumed.contains(act.dstName); });
+            }
+            std::erase_if(srcs, [](auto &p) { return p.second.empty(); });
+            std::string joined;
+            for (auto &&src : srcs | std::views::keys) {
+                if (!joined.empty()) {
+                    joined += ',';
+                }
+                joined += src;
+            }
+            subConsumed.insert_or_assign(from, std::move(joined));
+        }
+    }
+
+    /**
+     * @brief run a sub model flow nested in the engine's frame on the worker calling this model
+     *
+     * @return false if engine can not, the flow is then run one by one in dependency order
+     */
+    bool corun(tf::Taskflow &flow) {
+        return com_cb_ && CommonCallBack("CorunTaskflow", {{"Taskflow", &flow}}) == "1";
+    }
+
+    /**
+     * @brief prepare output slots of sub models, and task graphs for parallel tick / output if enabled
+     *
+     * @attention subModels must not change after this call until next Init
+     */
+    void buildSubModelFlow() {
+        outputSlots.clear();
+        ordered.clear();
+        tickFlow.clear();
+        outputFlow.clear();
+        for (auto &&[modelName, sub] : subModels) {
+            outputSlots.push_back({modelName, nullptr, sub.handle.outputDataMovable});
+        }
+        // config lists sub models in dependency order
+        for (auto &&m : config->models) {
+            auto slot = std::ranges::find(outputSlots, m.name, &TransformInfo::InputBuffer::name);
+            ordered.emplace_back(&subModels.find(m.name)->second, &*slot);
+        }
+        if (!config->parallel) {
+            return;
+        }
+        std::unordered_map<std::string_view, std::pair<tf::Task, tf::Task>> tasks;
+        auto slotIt = outputSlots.begin();
+        for (auto &sub : subModels) {
+            const std::string &modelName = sub.first;
+            CSModelObject *obj = sub.second.handle.obj;
+            auto zone = sub.second.zone;
+            auto tick = tickFlow.emplace([this, zone, obj] {
+                auto p = profiler.startRecord(zone.tick);
+                obj->Tick(tickTime);
+            });
+            auto output = outputFlow.emplace([this, zone, obj, &slot = *slotIt++] {
+                auto p = profiler.startRecord(zone.output);
+                slot.buffer = obj->GetOutput();
+            });
+            tasks.emplace(modelName, std::pair{tick.name(modelName), output.name(modelName)});
+        }
+        for (auto &&[before, after] : config->dependencies) {
+            auto &[beforeTick, beforeOutput] = tasks.find(before)->second;
+            auto &[afterTick, afterOutput] = tasks.find(after)->second;
+            beforeTick.precede(afterTick);
+            beforeOutput.precede(afterOutput);
+        }
+    }
+
     void restart() {
         restartFlag = false;
 
+        tickFlow.clear();
+        outputFlow.clear();
+        outputSlots.clear();
+        ordered.clear();
         subModels.clear();
 
         {
-            // never init concurrently
+            // never init concurrently; config is cached, so only sub model creation and Init run here
             std::lock_guard<std::mutex> lck{restartLock};
             Init(initValue);
         }
@@ -245,13 +330,30 @@ class MyAssembledModel : public CSModelObject {
     inline static std::mutex restartLock{};
 
     Profiler profiler;
-    uint32_t logLevel;
-    std::string profileFile, restartKey, sideFilter;
+    struct {
+        Profiler::ZoneID init, beforeInput, beforeOutput, afterOutput;
+    } rootZone;
+    struct SubModel {
+        ModelObjHandle handle;
+        struct {
+            Profiler::ZoneID init, tick, input, output;
+        } zone;
+    };
     bool restartFlag = false;
     CSValueMap initValue;
     CSValueMap outputBuffer;
-    TransformInfo init, input, output;
-    std::unordered_map<std::string, ModelObjHandle> subModels;
+    std::shared_ptr<const AssembleConfig> config;
+    // output_convert of config without rules nobody reads
+    TransformInfo outputRules;
+    // sub model name -> reply of its GetConsumedFields
+    std::unordered_map<std::string, std::string> subConsumed;
+    // same order as subModels
+    std::vector<TransformInfo::InputBuffer> outputSlots;
+    // sub models and their output slots in dependency order
+    std::vector<std::pair<SubModel *, TransformInfo::InputBuffer *>> ordered;
+    double tickTime = 0.;
+    tf::Taskflow tickFlow, outputFlow;
+    std::unordered_map<std::string, SubModel> subModels;
 };
 
 extern "C" {
@@ -14,7 +14,11 @@
  */
 #pragma once
 
+#include <algorithm>
 #include <any>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
 #include <expected>
 #include <format>
 #include <memory>
@@ -44,6 +48,8 @@ inline std::string toXML(const std::any &v) { return printAnyToString<XMLFormat>
 enum struct parseError {
     different_type_in_same_list,
     unknown_type,
+    syntax_error,
+    invalid_number,
 };
 
 inline std::expected<std::any, parseError> parseXML(rapidxml::xml_node<char> *node) {
@@ -101,14 +107,18 @@ inline std::expected<std::any, parseError> parseXML(rapidxml::xml_node<char> *no
         if (type == "float"sv)
             return float(stof(value));
         if (type == "double"sv)
-            return double(stof(value));
+            return double(stod(value));
         if (type == "string"sv)
             return string{value};
         return std::unexpected(parseError::unknown_type);
     }
 }
 
-inline std::expected<std::any, parseError> parseXMLString(const std::string &node) {
+/**
+ * @brief parse through rapidxml DOM, kept for comparison with parseXMLStringView
+ *
+ */
+inline std::expected<std::any, parseError> parseXMLStringDOM(const std::string &node) {
     size_t strLen = node.size() + 1;
     auto buffer = std::make_unique<char[]>(strLen);
     memcpy(buffer.get(), node.c_str(), strLen);
@@ -118,6 +128,350 @@ inline std::expected<std::any, parseError> parseXMLString(const std::string &nod
     return parseXML(root);
 }
 
+namespace detail {
+
+/**
+ * @brief single pass recursive descent parser of the grammar written by toXML, without building DOM
+ *
+ */
+struct XMLViewParser {
+    std::string_view in;
+    size_t pos = 0;
+
+    void skipSpace() {
+        while (pos < in.size() && isSpace(in[pos])) {
+            ++pos;
+        }
+    }
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+    // skip whitespace, comments, declarations, processing instructions and doctype, which rapidxml skips too
+    void skipMisc() {
+        using namespace std::literals;
+        for (skipSpace(); pos < in.size(); skipSpace()) {
+            auto rest = in.substr(pos);
+            std::string_view close;
+            if (rest.starts_with("<!--"sv)) {
+                close = "-->"sv;
+            } else if (rest.starts_with("<?"sv)) {
+                close = "?>"sv;
+            } else if (rest.starts_with("<!"sv) && !rest.starts_with("<![CDATA["sv)) {
+                close = ">"sv;
+            } else {
+                return;
+            }
+            auto end = in.find(close, pos + 2);
+            pos = end == std::string_view::npos ? in.size() : end + close.size();
+        }
+    }
+    bool atCloseTag() const { return in.substr(pos, 2) == "</"; }
+
+    // read "<name attr='value'>" or "<name/>", attributes are ignored like in DOM path; return false on syntax error
+    bool openTag(std::string_view &name, bool &empty) {
+        if (pos >= in.size() || in[pos] != '<') {
+            return false;
+        }
+        auto begin = ++pos;
+        while (pos < in.size() && in[pos] != '>' && in[pos] != '/' && !isSpace(in[pos])) {
+            ++pos;
+        }
+        name = in.substr(begin, pos - begin);
+        for (skipSpace(); pos < in.size() && in[pos] != '>' && in[pos] != '/'; skipSpace()) {
+            // attribute: name = "value" | 'value'
+            pos = in.find('=', pos);
+            if (pos == std::string_view::npos) {
+                pos = in.size();
+                return false;
+            }
+            ++pos;
+            skipSpace();
+            if (pos >= in.size() || (in[pos] != '"' && in[pos] != '\'')) {
+                return false;
+            }
+            auto end = in.find(in[pos], pos + 1);
+            if (end == std::string_view::npos) {
+                return false;
+            }
+            pos = end + 1;
+        }
+        empty = in.substr(pos, 2) == "/>";
+        if (empty) {
+            pos += 2;
+            return !name.empty();
+        }
+        if (pos >= in.size() || in[pos] != '>') {
+            return false;
+        }
+        ++pos;
+        return !name.empty();
+    }
+    bool closeTag(std::string_view name) {
+        if (!atCloseTag() || in.substr(pos + 2, name.size()) != name) {
+            return false;
+        }
+        pos += 2 + name.size();
+        skipSpace();
+        if (pos >= in.size() || in[pos] != '>') {
+            return false;
+        }
+        ++pos;
+        return true;
+    }
+
+    // parse one element, its name is stored to tag if given
+    std::expected<std::any, parseError> element(std::string_view *tag = nullptr) {
+        using namespace std::literals;
+        std::string_view name;
+        bool empty;
+        if (!openTag(name, empty)) {
+            return std::unexpected(parseError::syntax_error);
+        }
+        if (tag) {
+            *tag = name;
+        }
+        if (name == "li"sv) {
+            std::vector<std::any> ret;
+            if (empty) {
+                return ret;
+            }
+            std::string_view type;
+            for (skipMisc(); !atCloseTag(); skipMisc()) {
+                std::string_view childType;
+                auto v = element(&childType);
+                if (!v) {
+                    return std::unexpected(v.error());
+                }
+                if (ret.empty()) {
+                    type = childType;
+                } else if (childType != type) {
+                    return std::unexpected(parseError::different_type_in_same_list);
+                }
+                ret.push_back(std::move(v.value()));
+            }
+            if (!closeTag(name)) {
+                return std::unexpected(parseError::syntax_error);
+            }
+            return ret;
+        } else if (name == "c"sv) {
+            std::unordered_map<std::string, std::any> ret;
+            if (!empty) {
+                if (auto ans = mapBody(ret); !ans) {
+                    return std::unexpected(ans.error());
+                }
+            }
+            return ret;
+        }
+        std::string_view text;
+        if (!empty) {
+            auto end = in.find('<', pos);
+            if (end == std::string_view::npos) {
+                return std::unexpected(parseError::syntax_error);
+            }
+            text = in.substr(pos, end - pos);
+            pos = end;
+            // like rapidxml value(), only text before a comment counts
+            for (skipMisc(); pos < in.size() && in[pos] != '<'; skipMisc()) {
+                pos = std::min(in.find('<', pos), in.size());
+            }
+            if (!closeTag(name)) {
+                return std::unexpected(parseError::syntax_error);
+            }
+        }
+        return scalar(name, text);
+    }
+
+    // members of a "<c>" whose open tag is consumed, until and including "</c>"; first value of a duplicate name wins
+    // like in DOM path
+    std::expected<void, parseError> mapBody(std::unordered_map<std::string, std::any> &ret) {
+        for (skipMisc(); !atCloseTag(); skipMisc()) {
+            std::string_view key;
+            bool empty;
+            if (!openTag(key, empty) || empty) {
+                return std::unexpected(parseError::syntax_error);
+            }
+            skipMisc();
+            auto v = element();
+            if (!v) {
+                return std::unexpected(v.error());
+            }
+            skipMisc();
+            if (!closeTag(key)) {
+                return std::unexpected(parseError::syntax_error);
+            }
+            ret.emplace(std::string{key}, std::move(v.value()));
+        }
+        if (!closeTag("c")) {
+            return std::unexpected(parseError::syntax_error);
+        }
+        return {};
+    }
+
+    template <typename Ty> static std::expected<std::any, parseError> number(std::string_view text) {
+        while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) {
+            text.remove_prefix(1);
+        }
+        while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) {
+            text.remove_suffix(1);
+        }
+        // accepted by stoi / stod of DOM path, but not by from_chars
+        if (text.starts_with('+') && !text.substr(1).starts_with('-')) {
+            text.remove_prefix(1);
+        }
+        // 8 bit types are written as numbers, parse them as int like stoi
+        using Parsed = std::conditional_t<sizeof(Ty) == 1, int, Ty>;
+        Parsed v{};
+        auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), v);
+        if (ec != std::errc{} || ptr != text.data() + text.size()) {
+            return std::unexpected(parseError::invalid_number);
+        }
+        if constexpr (std::is_same_v<Ty, bool>) {
+            return bool(v);
+        } else {
+            return Ty(v);
+        }
+    }
+
+    static void appendUtf8(std::string &out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += char(cp);
+        } else if (cp < 0x800) {
+            out += char(0xC0 | (cp >> 6));
+            out += char(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            out += char(0xE0 | (cp >> 12));
+            out += char(0x80 | ((cp >> 6) & 0x3F));
+            out += char(0x80 | (cp & 0x3F));
+        } else {
+            out += char(0xF0 | (cp >> 18));
+            out += char(0x80 | ((cp >> 12) & 0x3F));
+            out += char(0x80 | ((cp >> 6) & 0x3F));
+            out += char(0x80 | (cp & 0x3F));
+        }
+    }
+
+    // decode "&#65;" or "&#x41;" at front of text as UTF-8 like rapidxml does, return length consumed or 0 if invalid
+    static size_t charReference(std::string_view text, std::string &out) {
+        auto end = text.find(';');
+        if (!text.starts_with("&#") || end == std::string_view::npos) {
+            return 0;
+        }
+        auto digits = text.substr(2, end - 2);
+        int base = 10;
+        if (digits.starts_with('x')) {
+            digits.remove_prefix(1);
+            base = 16;
+        }
+        uint32_t cp = 0;
+        auto [ptr, ec] = std::from_chars(digits.data(), digits.data() + digits.size(), cp, base);
+        if (digits.empty() || ec != std::errc{} || ptr != digits.data() + digits.size() || cp > 0x10FFFF) {
+            return 0;
+        }
+        appendUtf8(out, cp);
+        return end + 1;
+    }
+
+    static std::string unescape(std::string_view text) {
+        using namespace std::literals;
+        std::string ret;
+        ret.reserve(text.size());
+        static constexpr std::pair<std::string_view, char> entities[]{
+            {"&lt;"sv, '<'}, {"&gt;"sv, '>'}, {"&amp;"sv, '&'}, {"&quot;"sv, '"'}, {"&apos;"sv, '\''}};
+        while (!text.empty()) {
+            auto p = text.find('&');
+            ret.append(text.substr(0, p));
+            if (p == std::string_view::npos) {
+                break;
+            }
+            text.remove_prefix(p);
+            auto it = std::ranges::find_if(entities, [&](auto &e) { return text.starts_with(e.first); });
+            if (auto n = it == std::end(entities) ? charReference(text, ret) : 0; n != 0) {
+                text.remove_prefix(n);
+            } else if (it == std::end(entities)) {
+                ret += '&';
+                text.remove_prefix(1);
+            } else {
+                ret += it->second;
+                text.remove_prefix(it->first.size());
+            }
+        }
+        return ret;
+    }
+
+    static std::expected<std::any, parseError> scalar(std::string_view type, std::string_view text) {
+        using namespace std::literals;
+        if (type == "double"sv)
+            return number<double>(text);
+        if (type == "string"sv)
+            return text.contains('&') ? unescape(text) : std::string{text};
+        if (type == "float"sv)
+            return number<float>(text);
+        if (type == "uint64_t"sv)
+            return number<uint64_t>(text);
+        if (type == "int64_t"sv)
+            return number<int64_t>(text);
+        if (type == "uint32_t"sv)
+            return number<uint32_t>(text);
+        if (type == "int32_t"sv)
+            return number<int32_t>(text);
+        if (type == "uint16_t"sv)
+            return number<uint16_t>(text);
+        if (type == "int16_t"sv)
+            return number<int16_t>(text);
+        if (type == "uint8_t"sv)
+            return number<uint8_t>(text);
+        if (type == "int8_t"sv)
+            return number<int8_t>(text);
+        if (type == "bool"sv)
+            return number<bool>(text);
+        return std::unexpected(parseError::unknown_type);
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief parse value written in XMLFormat directly from string, without copy or DOM
+ *
+ * @param node text of one element, surrounding whitespace, comments and declarations allowed
+ */
+inline std::expected<std::any, parseError> parseXMLStringView(std::string_view node) {
+    detail::XMLViewParser p{node};
+    p.skipMisc();
+    auto ret = p.element();
+    p.skipMisc();
+    if (ret && p.pos != node.size()) {
+        return std::unexpected(parseError::syntax_error);
+    }
+    return ret;
+}
+
+/**
+ * @brief parse a "<c>" element into given map, existing entries with same names are kept
+ *
+ * @details reuse a cleared map to keep its buckets between calls
+ */
+inline std::expected<void, parseError> parseXMLStringViewInto(std::string_view node, std::unordered_map<std::string, std::any> &out) {
+    using namespace std::literals;
+    detail::XMLViewParser p{node};
+    p.skipMisc();
+    std::string_view name;
+    bool empty;
+    if (!p.openTag(name, empty) || name != "c"sv) {
+        return std::unexpected(parseError::syntax_error);
+    }
+    if (!empty) {
+        if (auto ans = p.mapBody(out); !ans) {
+            return ans;
+        }
+    }
+    p.skipMisc();
+    if (p.pos != node.size()) {
+        return std::unexpected(parseError::syntax_error);
+    }
+    return {};
+}
+
+inline std::expected<std::any, parseError> parseXMLString(const std::string &node) { return parseXMLStringView(node); }
+
 } // namespace tools::myany
 
 template <>
@@ -128,6 +482,10 @@ struct std::formatter<tools::myany::parseError, char> {
         std::string_view out;
         if (err == tools::myany::parseError::different_type_in_same_list)
             out = "[different_type_in_same_list]";
+        else if (err == tools::myany::parseError::syntax_error)
+            out = "[syntax_error]";
+        else if (err == tools::myany::parseError::invalid_number)
+            out = "[invalid_number]";
         else
             out = "[unknown_type]";
         return std::ranges::copy(out, ctx.out()).out;
@@ -0,0 +1,132 @@
+/**
+ * @file perthread.hpp
+ * @author glutamate
+ * @brief per-thread instance storage of an object, accessed without lock after first touch
+ * @version 0.1
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tools {
+
+inline uint64_t nextPerThreadUid() {
+    static std::atomic<uint64_t> counter{1};
+    return counter.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief one T for every thread touching this object, all of them are kept until this object destructs
+ *
+ * @details T is constructed on the thread that first calls local(), so its member initializers may use thread
+ * identity. values of exited threads remain visible to forEach.
+ *
+ * @attention forEach takes the registry lock, but does not synchronize with owners writing their T
+ */
+template <typename T> class PerThread {
+  public:
+    PerThread() : uid(nextPerThreadUid()) {}
+    PerThread(const PerThread &) = delete;
+    PerThread &operator=(const PerThread &) = delete;
+
+    T &local() {
+        struct Entry {
+            std::weak_ptr<void> owner;
+            T *value;
+        };
+        // object uid -> T of this thread; uid never reused, so entries of dead objects are never hit
+        thread_local std::unordered_map<uint64_t, Entry> instances;
+        thread_local uint64_t lastUid = 0;
+        thread_local T *last = nullptr;
+        if (lastUid == uid) [[likely]] {
+            return *last;
+        }
+        auto it = instances.find(uid);
+        if (it == instances.end()) {
+            // drop entries of destroyed objects, so a thread keeps at most one entry per live object plus those died
+            // since it last met a new object
+            std::erase_if(instances, [](auto &e) { return e.second.owner.expired(); });
+            auto item = std::make_unique<T>();
+            it = instances.emplace(uid, Entry{alive, item.get()}).first;
+            std::lock_guard<std::mutex> lck{lock};
+            items.push_back(std::move(item));
+        }
+        lastUid = uid;
+        last = it->second.value;
+        return *last;
+    }
+
+    template <typename Fn> void forEach(Fn &&fn) {
+        std::lock_guard<std::mutex> lck{lock};
+        for (auto &&item : items) {
+            fn(*item);
+        }
+    }
+
+  private:
+    const uint64_t uid;
+    // expires when this object destructs, tells threads their entries of it are dead
+    std::shared_ptr<void> alive = std::make_shared<char>();
+    std::mutex lock;
+    std::vector<std::unique_ptr<T>> items;
+};
+
+/**
+ * @brief multi-producer single-consumer bag, each producer thread pushes onto its own lock-free stack
+ *
+ * @attention only one thread may take at a time
+ */
+template <typename T> class PerThreadStack {
+  public:
+    void push(T value) {
+        auto node = new Node{std::move(value), nullptr};
+        auto &head = stacks.local().head;
+        node->next = head.load(std::memory_order_relaxed);
+        while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    /**
+     * @brief take all pushed values, values pushed by one thread keep their order
+     */
+    std::vector<T> take() {
+        std::vector<T> ret;
+        stacks.forEach([&ret](Stack &s) {
+            auto begin = ret.size();
+            for (auto node = s.head.exchange(nullptr, std::memory_order_acquire); node;) {
+                ret.push_back(std::move(node->value));
+                delete std::exchange(node, node->next);
+            }
+            std::reverse(ret.begin() + begin, ret.end());
+        });
+        return ret;
+    }
+
+  private:
+    struct Node {
+        T value;
+        Node *next;
+    };
+    struct Stack {
+        std::atomic<Node *> head = nullptr;
+        ~Stack() {
+            for (auto node = head.load(); node;) {
+                delete std::exchange(node, node->next);
+            }
+        }
+    };
+    PerThread<Stack> stacks;
+};
+
+} // namespace tools
@@ -15,12 +15,14 @@
 #pragma once
 
 #include <any>
+#include <charconv>
 #include <format>
 #include <iostream>
 #include <ranges>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 #include <array>
 #include <string_view>
@@ -82,42 +84,136 @@ struct CppFormat {
     inline static constexpr auto Spliter = ", ";
 };
 
-template <typename Formation = DefaultFormat>
-std::string printCSValueMapToString(const std::unordered_map<std::string, std::any> &v);
+namespace helper {
 
-template <typename Formation = DefaultFormat>
-inline std::string printAnyToString(const std::any &a) {
-    struct UnknownTypeHandler{
-        std::string operator()(const std::any &v){
-            return Formation::UnknownFormat;
+    /**
+     * @brief append pattern to out, with "{}" or "{N}" replaced by calling the corresponding appender and "{{" / "}}"
+     * unescaped, same syntax as std::format without format spec
+     */
+    template <typename... Fn>
+    inline void appendPattern(std::string &out, std::string_view pattern, Fn &&...appenders) {
+        auto call = [&](size_t idx) {
+            size_t i = 0;
+            ((i++ == idx ? (appenders(), 0) : 0), ...);
+        };
+        size_t next = 0;
+        for (size_t i = 0; i < pattern.size(); ++i) {
+            char c = pattern[i];
+            if ((c == '{' || c == '}') && i + 1 < pattern.size() && pattern[i + 1] == c) {
+                out += c;
+                ++i;
+            } else if (c == '{') {
+                auto end = pattern.find('}', i);
+                size_t idx = next++;
+                if (end > i + 1) {
+                    std::from_chars(pattern.data() + i + 1, pattern.data() + end, idx);
+                }
+                call(idx);
+                i = end;
+            } else {
+                out += c;
+            }
         }
-    };
-    return myany::visit<UnknownTypeHandler>(
-        [](const auto& a) {
-            if constexpr (std::is_same_v<std::vector<std::any>, std::remove_cvref_t<decltype(a)>>) {
-                return std::format(Formation::ArrayFormat, mystr::join(a | std::views::transform(printAnyToString<Formation>), Formation::Spliter));
+    }
+
+    template <typename Ty> inline void appendNumber(std::string &out, Ty v) {
+        char buf[64];
+        // 1 byte types and bool are written as integers like std::to_string
+        using Printed = std::conditional_t<sizeof(Ty) == 1, int, Ty>;
+        auto [ptr, ec] = std::to_chars(buf, buf + sizeof(buf), Printed(v));
+        out.append(buf, ptr);
+        // keep floats distinguishable from integers like std::to_string did, python side evals this text
+        if constexpr (std::is_floating_point_v<Ty>) {
+            if (std::string_view(buf, ptr).find_first_of(".ein") == std::string_view::npos) {
+                out += ".0";
             }
-            else if constexpr (std::is_same_v<std::unordered_map<std::string, std::any>,
-                std::remove_cvref_t<decltype(a)>>) {
-                return printCSValueMapToString<Formation>(a);
+        }
+    }
+
+}
+
+template <typename Formation = DefaultFormat>
+inline void appendAnyToString(std::string &out, const std::any &a);
+
+/**
+ * @brief append CSValueMap to out in given format, without temporary strings
+ *
+ */
+template <typename Formation = DefaultFormat>
+inline void appendCSValueMapToString(std::string &out, const std::unordered_map<std::string, std::any> &v) {
+    helper::appendPattern(out, Formation::CSValueMapFormat, [&] {
+        bool first = true;
+        for (auto &&[name, value] : v) {
+            if (!std::exchange(first, false)) {
+                out += Formation::Spliter;
             }
-            else if constexpr (std::is_same_v<std::string, std::remove_cvref_t<decltype(a)>>) {
-                return std::format(Formation::StringFormat, a);
+            helper::appendPattern(
+                out, Formation::PairFormat, [&] { out += name; }, [&] { appendAnyToString<Formation>(out, value); });
+        }
+    });
+}
+
+/**
+ * @brief append list to out in given format, without temporary strings
+ *
+ */
+template <typename Formation = DefaultFormat>
+inline void appendListToString(std::string &out, const std::vector<std::any> &v) {
+    helper::appendPattern(out, Formation::ArrayFormat, [&] {
+        bool first = true;
+        for (auto &&value : v) {
+            if (!std::exchange(first, false)) {
+                out += Formation::Spliter;
             }
-            else {
-                return std::format(Formation::NumericalFormat, helper::numericalTypeNameTable.getName<std::remove_cvref_t<decltype(a)>>(), std::to_string(a));
+            appendAnyToString<Formation>(out, value);
+        }
+    });
+}
+
+/**
+ * @brief append value in any to out in given format, without temporary strings
+ *
+ * @details numbers are written by std::to_chars in shortest round-trip form
+ */
+template <typename Formation>
+inline void appendAnyToString(std::string &out, const std::any &a) {
+    struct UnknownTypeHandler {
+        bool operator()(const std::any &v) { return false; }
+    };
+    bool known = myany::visit<UnknownTypeHandler>(
+        [&out](const auto &a) {
+            using Ty = std::remove_cvref_t<decltype(a)>;
+            if constexpr (std::is_same_v<std::vector<std::any>, Ty>) {
+                appendListToString<Formation>(out, a);
+            } else if constexpr (std::is_same_v<std::unordered_map<std::string, std::any>, Ty>) {
+                appendCSValueMapToString<Formation>(out, a);
+            } else if constexpr (std::is_same_v<std::string, Ty>) {
+                helper::appendPattern(out, Formation::StringFormat, [&] { out += a; });
+            } else {
+                helper::appendPattern(
+                    out, Formation::NumericalFormat, [&] { out += helper::numericalTypeNameTable.getName<Ty>(); },
+                    [&] { helper::appendNumber(out, a); });
             }
+            return true;
         },
         a);
+    if (!known) {
+        out += Formation::UnknownFormat;
+    }
 }
 
-template <typename Formation>
+template <typename Formation = DefaultFormat>
+inline std::string printAnyToString(const std::any &a) {
+    std::string ret;
+    appendAnyToString<Formation>(ret, a);
+    return ret;
+}
+
+template <typename Formation = DefaultFormat>
 inline std::string printCSValueMapToString(const std::unordered_map<std::string, std::any> &v) {
-    using namespace std;
-    return std::format(Formation::CSValueMapFormat, mystr::join(v | std::views::transform([](const auto& p) {
-        return std::format(Formation::PairFormat, p.first, printAnyToString<Formation>(p.second));
-        }),
-        Formation::Spliter));
+    std::string ret;
+    appendCSValueMapToString<Formation>(ret, v);
+    return ret;
 }
 
 /**
@@ -1,81 +1,221 @@
+/**
+ * @file profile.hpp
+ * @author glutamate
+ * @brief thread-safe scoped profiler with per-zone statistics and chrome trace export
+ * @version 0.2
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
 #pragma once
 
-#include <string>
-#ifdef __ENABLE_PROFILE
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
-#include <initializer_list>
-#include <map>
+#include <deque>
+#include <format>
+#include <mutex>
+#include <ranges>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
-#include <mutex>
-#include <atomic>
 
+#include "perthread.hpp"
 #include "stringprocess.hpp"
-#endif
 
+/**
+ * @brief scoped profiler, disabled by default and can be switched at runtime
+ *
+ * @details zones are registered once (e.g. at Init) and referenced by id on hot path. every thread records into its
+ * own buffer without lock, buffers are merged only when result is requested.
+ *
+ * @attention getResult / getChromeTrace / reset should not run concurrently with recording
+ */
 struct Profiler {
+    using ZoneID = uint32_t;
+    using clock = std::chrono::steady_clock;
+
+    Profiler() = default;
+    Profiler(const Profiler &) = delete;
+    Profiler &operator=(const Profiler &) = delete;
+
     struct Counter {
-#ifdef __ENABLE_PROFILE
-        Counter(Profiler *p, std::string id) : t1(std::chrono::high_resolution_clock::now()), p(p), id(std::move(id)) {}
+        Counter() = default;
+        Counter(Profiler *p, ZoneID id) : p(p), id(id), t1(clock::now()) {}
+        Counter(const Counter &) = delete;
+        Counter &operator=(const Counter &) = delete;
         void end() {
-            auto t2 = std::chrono::high_resolution_clock::now() - t1;
-            p->log(id, t2);
-            p = nullptr;
-        }
-        ~Counter() {
             if (p) {
-                end();
+                p->log(id, t1, clock::now());
+                p = nullptr;
             }
         }
-        Profiler *p;
-        std::string id;
-        std::chrono::steady_clock::time_point t1;
-#else
-        void end() {}
-#endif
+        ~Counter() { end(); }
+        Profiler *p = nullptr;
+        ZoneID id = 0;
+        clock::time_point t1;
     };
-    Counter startRecord(std::string id, Counter *end = nullptr) {
-#ifdef __ENABLE_PROFILE
+
+    /**
+     * @brief get id of a zone, register it if not exist
+     *
+     * @attention takes a lock, call it outside hot path and keep the id
+     */
+    ZoneID registerZone(std::string_view name) {
+        std::lock_guard<std::mutex> lck{lock};
+        if (auto it = zoneIndex.find(name); it != zoneIndex.end()) {
+            return it->second;
+        }
+        auto id = ZoneID(zones.size());
+        zones.emplace_back(name);
+        zoneIndex.emplace(zones.back(), id);
+        return id;
+    }
+
+    void enable(bool on = true) { enabled.store(on, std::memory_order_relaxed); }
+    /**
+     * @brief also keep every single record for chrome trace export, implies enable
+     */
+    void enableTrace(bool on = true) {
+        trace.store(on, std::memory_order_relaxed);
+        if (on) {
+            enable();
+        }
+    }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief start record a zone, record ends when returned counter destructed or end() called
+     *
+     * @param id zone id from registerZone
+     * @param end counter to end before start this record
+     */
+    Counter startRecord(ZoneID id, Counter *end = nullptr) {
         if (end) {
             end->end();
         }
-        return Counter{this, std::move(id)};
-#else
-        return Counter{};
-#endif
-    }
-#ifdef __ENABLE_PROFILE
-    void log(const std::string &id, std::chrono::nanoseconds time) {
-        if(auto it = logs.find(id); it == logs.end()) {
-            std::unique_lock<> lock{};
+        if (!isEnabled()) {
+            return Counter{};
         }
-        logs[id].times++;
-        logs[id].totalTime += time;
+        return Counter{this, id};
     }
-    struct Log {
-        size_t times;
-        std::atomic<std::chrono::nanoseconds> totalTime;
-    };
-    std::map<std::string, Log, std::less<>> logs;
+
+    void reset() {
+        threads.forEach([](ThreadBuffer &t) {
+            t.stats.clear();
+            t.events.clear();
+        });
+    }
+
     std::string getResult() {
         using std::to_string;
-        std::vector<std::array<std::string, 9>> ans;
-        ans.reserve(logs.size());
-        for (auto &&[name, log] : logs) {
-            auto t = std::chrono::duration_cast<std::chrono::microseconds>(log.totalTime);
-            ans.push_back({"[", std::move(name), " ]: ", to_string(t.count()), " us / ", to_string(log.times),
-                           " times = ", to_string(double(t.count()) / log.times), " us\n"});
+        std::lock_guard<std::mutex> lck{lock};
+        std::vector<ZoneStat> merged(zones.size());
+        threads.forEach([&merged](ThreadBuffer &t) {
+            for (size_t i = 0; i < t.stats.size(); ++i) {
+                merged[i].times += t.stats[i].times;
+                merged[i].totalTime += t.stats[i].totalTime;
+            }
+        });
+        std::vector<std::pair<std::chrono::microseconds, std::array<std::string, 9>>> ans;
+        ans.reserve(zones.size());
+        for (size_t i = 0; i < zones.size(); ++i) {
+            if (merged[i].times == 0) {
+                continue;
+            }
+            auto t = std::chrono::duration_cast<std::chrono::microseconds>(merged[i].totalTime);
+            ans.push_back({t,
+                           {"[", zones[i], " ]: ", to_string(t.count()), " us / ", to_string(merged[i].times),
+                            " times = ", to_string(double(t.count()) / merged[i].times), " us\n"}});
+        }
+        if (ans.empty()) {
+            return isEnabled() ? "[no record]" : "[profile disabled]";
         }
-        std::sort(ans.begin(), ans.end(),
-                  [](const auto &l, const auto &r) { return std::stoi(l[3]) > std::stoi(r[3]); });
+        std::ranges::sort(ans, std::ranges::greater{}, &decltype(ans)::value_type::first);
+        auto table = ans | std::views::values | std::ranges::to<std::vector>();
         constexpr std::array<bool, 9> alignConfig{true, false, true, true, true, true, true, true, true};
-        tools::mystr::align(ans, alignConfig);
+        tools::mystr::align(table, alignConfig);
         return tools::mystr::join(
-            ans | std::views::transform([](auto &v) { return tools::mystr::join(std::move(v), ""); }), "");
+            table | std::views::transform([](auto &v) { return tools::mystr::join(std::move(v), ""); }), "");
+    }
+
+    /**
+     * @brief export recorded events in chrome trace event format, loadable by chrome://tracing and perfetto
+     *
+     * @param pid process id shown in trace viewer
+     */
+    std::string getChromeTrace(uint32_t pid = 0) {
+        std::lock_guard<std::mutex> lck{lock};
+        std::string ret = R"({"displayTimeUnit":"ns","traceEvents":[)";
+        bool first = true;
+        auto us = [](int64_t ns) { return double(ns) / 1000.; };
+        threads.forEach([&](ThreadBuffer &t) {
+            for (auto &&[id, start, dur] : t.events) {
+                ret += first ? "\n" : ",\n";
+                first = false;
+                ret += std::format(
+                    R"({{"name":"{}","cat":"profiler","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":{},"tid":{}}})",
+                    escape(zones[id]), us(start), us(dur), pid, t.tid);
+            }
+        });
+        ret += "\n]}";
+        return ret;
+    }
+
+  private:
+    struct ZoneStat {
+        size_t times = 0;
+        std::chrono::nanoseconds totalTime{0};
+    };
+    struct Event {
+        ZoneID id;
+        // ns since clock epoch
+        int64_t start, duration;
+    };
+    struct ThreadBuffer {
+        uint32_t tid = threadID();
+        std::vector<ZoneStat> stats;
+        std::vector<Event> events;
+    };
+
+    void log(ZoneID id, clock::time_point t1, clock::time_point t2) {
+        auto &buffer = threads.local();
+        if (id >= buffer.stats.size()) [[unlikely]] {
+            buffer.stats.resize(id + 1);
+        }
+        auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1);
+        buffer.stats[id].times++;
+        buffer.stats[id].totalTime += time;
+        if (trace.load(std::memory_order_relaxed)) {
+            buffer.events.push_back(
+                {id, std::chrono::duration_cast<std::chrono::nanoseconds>(t1.time_since_epoch()).count(),
+                 time.count()});
+        }
+    }
+
+    static uint32_t threadID() {
+        static std::atomic<uint32_t> counter{0};
+        thread_local uint32_t id = counter.fetch_add(1, std::memory_order_relaxed);
+        return id;
     }
-#else
-    std::string getResult() { return "[profile disabled]"; }
-#endif
-};
\ No newline at end of file
+    static std::string escape(std::string_view s) {
+        std::string ret;
+        for (char c : s) {
+            if (c == '"' || c == '\\') {
+                ret += '\\';
+            }
+            ret += c;
+        }
+        return ret;
+    }
+
+    std::atomic<bool> enabled = false, trace = false;
+    std::mutex lock;
+    // deque keeps zone names in place for zoneIndex
+    std::deque<std::string> zones;
+    std::unordered_map<std::string_view, ZoneID> zoneIndex;
+    tools::PerThread<ThreadBuffer> threads;
+};